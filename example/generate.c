@@ -47,7 +47,7 @@ int main(void) {
   err = cmsc_sipmsg_insert_via(
       strlen("SIP/2.0/UDP"), "SIP/2.0/UDP", strlen("client.example.com"),
       "client.example.com", 0, NULL, strlen("z9hG4bKbranch123"),
-      "z9hG4bKbranch123", 0, NULL, 0, msg);
+      "z9hG4bKbranch123", 0, NULL, 0, false, msg);
   if (err)
     goto error_out;
 
@@ -13,9 +13,13 @@
 #include <stdlib.h>
 
 #include <sys/queue.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
 #include <c_minilib_error.h>
 
+#include "c_minilib_sip_codec_headers.h"
+
 //
 ////
 //////
@@ -42,24 +46,40 @@ struct cmsc_String {
   const char *buf;
 };
 
+/* cmsc_init has to be called once, before messages are parsed by any thread,
+   cmsc_parse_sip fails with EINVAL without it. cmsc_destroy drops registered
+   headers, so messages holding extensions have to be destroyed before it. */
 cme_error_t cmsc_init(void);
 void cmsc_destroy(void);
 
+// Structs of headers generated from scripts/headers.abnf
+#include "c_minilib_sip_codec_generated.h"
+
 /******************************************************************************
  *                             Message                                        *
  ******************************************************************************/
+enum cmsc_SupportedSipHeadersBits {
+  cmsc_SupportedSipHeadersBits_REQUEST_LINE,
+  cmsc_SupportedSipHeadersBits_STATUS_LINE,
+#define CMSC_X(id, ...) cmsc_SupportedSipHeadersBits_##id,
+  CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
+  cmsc_SupportedSipHeadersBits_MAX,
+};
+
+_Static_assert(cmsc_SupportedSipHeadersBits_MAX < 32,
+               "Supported headers do not fit into `presence_mask`");
+
 enum cmsc_SupportedSipHeaders {
   cmsc_SupportedSipHeaders_NONE = 0,
-  cmsc_SupportedSipHeaders_REQUEST_LINE = 1,
-  cmsc_SupportedSipHeaders_STATUS_LINE = 2,
-  cmsc_SupportedSipHeaders_TO = 4,
-  cmsc_SupportedSipHeaders_FROM = 8,
-  cmsc_SupportedSipHeaders_CSEQ = 16,
-  cmsc_SupportedSipHeaders_CALL_ID = 32,
-  cmsc_SupportedSipHeaders_MAX_FORWARDS = 64,
-  cmsc_SupportedSipHeaders_VIAS = 128,
-  cmsc_SupportedSipHeaders_CONTENT_LENGTH = 256,
-  // Add more fields here
+  cmsc_SupportedSipHeaders_REQUEST_LINE =
+      1 << cmsc_SupportedSipHeadersBits_REQUEST_LINE,
+  cmsc_SupportedSipHeaders_STATUS_LINE =
+      1 << cmsc_SupportedSipHeadersBits_STATUS_LINE,
+#define CMSC_X(id, ...)                                                        \
+  cmsc_SupportedSipHeaders_##id = 1 << cmsc_SupportedSipHeadersBits_##id,
+  CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
   cmsc_SupportedSipHeaders_MAX,
 };
 
@@ -75,10 +95,34 @@ struct cmsc_SipStatusLine {
   uint32_t status_code;
 };
 
+/* Ids from cmsc_HeaderNames_MAX onwards belong to names registered with
+   cmsc_register_header which are not in CMSC_HEADER_NAMES, id is
+   cmsc_HeaderNames_MAX + slot. */
+enum cmsc_HeaderNames {
+  cmsc_HeaderNames_UNKNOWN = 0,
+#define CMSC_X(id, ...) cmsc_HeaderNames_##id,
+  CMSC_HEADER_NAMES(CMSC_X)
+#undef CMSC_X
+  cmsc_HeaderNames_MAX,
+};
+
+/* Generic headers are indexed by name on first lookup. Builds defining
+   CMSC_WITH_HEADERS_INDEX=0, which is what meson option `headers_index` does,
+   drop the index and walk `sip_headers` instead. */
+#ifndef CMSC_WITH_HEADERS_INDEX
+#define CMSC_WITH_HEADERS_INDEX 1
+#endif
+
 struct cmsc_SipHeader {
   struct cmsc_BString key;
   struct cmsc_BString value;
+  // One of cmsc_HeaderNames, assigned when header is split
+  uint16_t id;
   STAILQ_ENTRY(cmsc_SipHeader) _next;
+#if CMSC_WITH_HEADERS_INDEX
+  // Next header with the same name, valid only while index is built
+  struct cmsc_SipHeader *_next_same;
+#endif
 };
 
 STAILQ_HEAD(cmsc_SipHeadersList, cmsc_SipHeader);
@@ -104,26 +148,243 @@ struct cmsc_SipHeaderVia {
   struct cmsc_BString branch;
   struct cmsc_BString received;
   uint32_t ttl;
+  // Set if `rport` param is present, requests send it without value
+  bool has_rport;
+  uint32_t rport;
+  // Filled by cmsc_resolve_sip_vias, address responses should be sent to.
+  struct sockaddr_storage route_addr;
+  bool is_route_addr_resolved;
+  /* Whole parsed via, it is generated as is so forwarded vias keep their
+     params. Clear it after modifying fields of parsed via. */
+  struct cmsc_BString raw;
   STAILQ_ENTRY(cmsc_SipHeaderVia) _next;
 };
 
 STAILQ_HEAD(cmsc_SipViasList, cmsc_SipHeaderVia);
 
+// Route and Record-Route entry, RFC 3261 20.30 and 20.34
+struct cmsc_SipHeaderRoute {
+  struct cmsc_BString display_name;
+  struct cmsc_BString uri;
+  struct cmsc_BString params;
+  STAILQ_ENTRY(cmsc_SipHeaderRoute) _next;
+};
+
+STAILQ_HEAD(cmsc_SipRoutesList, cmsc_SipHeaderRoute);
+
+// Well known methods, used by Allow
+enum cmsc_SipMethods {
+  cmsc_SipMethods_NONE = 0,
+  cmsc_SipMethods_INVITE = 1,
+  cmsc_SipMethods_ACK = 2,
+  cmsc_SipMethods_BYE = 4,
+  cmsc_SipMethods_CANCEL = 8,
+  cmsc_SipMethods_OPTIONS = 16,
+  cmsc_SipMethods_REGISTER = 32,
+  cmsc_SipMethods_PRACK = 64,
+  cmsc_SipMethods_SUBSCRIBE = 128,
+  cmsc_SipMethods_NOTIFY = 256,
+  cmsc_SipMethods_PUBLISH = 512,
+  cmsc_SipMethods_INFO = 1024,
+  cmsc_SipMethods_REFER = 2048,
+  cmsc_SipMethods_MESSAGE = 4096,
+  cmsc_SipMethods_UPDATE = 8192,
+};
+
+// Well known option tags, used by Supported, Require, Proxy-Require and
+// Unsupported
+enum cmsc_SipOptionTags {
+  cmsc_SipOptionTags_NONE = 0,
+  cmsc_SipOptionTags_100REL = 1,
+  cmsc_SipOptionTags_TIMER = 2,
+  cmsc_SipOptionTags_REPLACES = 4,
+  cmsc_SipOptionTags_PATH = 8,
+  cmsc_SipOptionTags_GRUU = 16,
+  cmsc_SipOptionTags_OUTBOUND = 32,
+  cmsc_SipOptionTags_NOREFERSUB = 64,
+  cmsc_SipOptionTags_PRECONDITION = 128,
+  cmsc_SipOptionTags_EVENTLIST = 256,
+  cmsc_SipOptionTags_JOIN = 512,
+  cmsc_SipOptionTags_HISTINFO = 1024,
+  cmsc_SipOptionTags_FROM_CHANGE = 2048,
+  cmsc_SipOptionTags_SEC_AGREE = 4096,
+  cmsc_SipOptionTags_TDIALOG = 8192,
+  cmsc_SipOptionTags_199 = 16384,
+};
+
+struct cmsc_SipToken {
+  struct cmsc_BString token;
+  STAILQ_ENTRY(cmsc_SipToken) _next;
+};
+
+STAILQ_HEAD(cmsc_SipTokensList, cmsc_SipToken);
+
+// Well known tokens are kept in `mask`, the rest lands in `unknown`.
+struct cmsc_SipHeaderTokens {
+  uint32_t mask;
+  struct cmsc_SipTokensList unknown;
+};
+
+enum cmsc_MediaTypes {
+  cmsc_MediaTypes_NONE = 0,
+  cmsc_MediaTypes_UNKNOWN,
+  cmsc_MediaTypes_APPLICATION_SDP,
+  cmsc_MediaTypes_APPLICATION_PIDF_XML,
+  cmsc_MediaTypes_APPLICATION_RLMI_XML,
+  cmsc_MediaTypes_APPLICATION_DIALOG_INFO_XML,
+  cmsc_MediaTypes_APPLICATION_SIMPLE_MESSAGE_SUMMARY,
+  cmsc_MediaTypes_APPLICATION_ISUP,
+  cmsc_MediaTypes_APPLICATION_DTMF_RELAY,
+  cmsc_MediaTypes_MESSAGE_SIPFRAG,
+  cmsc_MediaTypes_MULTIPART_MIXED,
+  cmsc_MediaTypes_MULTIPART_ALTERNATIVE,
+  cmsc_MediaTypes_MULTIPART_RELATED,
+  cmsc_MediaTypes_TEXT_PLAIN,
+};
+
+struct cmsc_SipHeaderContentType {
+  enum cmsc_MediaTypes media_type;
+  // Whole `type/subtype`, parameters are kept raw in `params`
+  struct cmsc_BString type;
+  struct cmsc_BString params;
+  struct cmsc_BString boundary;
+  struct cmsc_BString charset;
+};
+
+struct cmsc_SipHeaderEvent {
+  struct cmsc_BString package;
+  struct cmsc_BString params;
+  struct cmsc_BString id;
+};
+
+enum cmsc_SubscriptionStates {
+  cmsc_SubscriptionStates_NONE = 0,
+  cmsc_SubscriptionStates_UNKNOWN,
+  cmsc_SubscriptionStates_ACTIVE,
+  cmsc_SubscriptionStates_PENDING,
+  cmsc_SubscriptionStates_TERMINATED,
+};
+
+struct cmsc_SipHeaderSubscriptionState {
+  enum cmsc_SubscriptionStates state;
+  struct cmsc_BString state_name;
+  struct cmsc_BString params;
+  struct cmsc_BString reason;
+  uint32_t expires;
+  uint32_t retry_after;
+};
+
+struct cmsc_SipHeaderIdentity {
+  struct cmsc_BString display_name;
+  struct cmsc_BString uri;
+  struct cmsc_BString params;
+  // Uri was enclosed in `<>`, bare addr-spec keeps its form when generated
+  bool is_name_addr;
+  STAILQ_ENTRY(cmsc_SipHeaderIdentity) _next;
+};
+
+STAILQ_HEAD(cmsc_SipIdentitiesList, cmsc_SipHeaderIdentity);
+
+struct cmsc_SipHeaderDiversion {
+  struct cmsc_BString display_name;
+  struct cmsc_BString uri;
+  struct cmsc_BString params;
+  struct cmsc_BString reason;
+  // According RFC 5806 counter defaults to 1
+  uint32_t counter;
+  STAILQ_ENTRY(cmsc_SipHeaderDiversion) _next;
+};
+
+STAILQ_HEAD(cmsc_SipDiversionsList, cmsc_SipHeaderDiversion);
+
+struct cmsc_SipHeaderHistoryInfo {
+  struct cmsc_BString display_name;
+  struct cmsc_BString uri;
+  struct cmsc_BString params;
+  struct cmsc_BString index;
+  STAILQ_ENTRY(cmsc_SipHeaderHistoryInfo) _next;
+};
+
+STAILQ_HEAD(cmsc_SipHistoryInfosList, cmsc_SipHeaderHistoryInfo);
+
+#ifndef CMSC_MAX_EXTENSION_SLOTS
+#define CMSC_MAX_EXTENSION_SLOTS 16
+#endif
+#if CMSC_MAX_EXTENSION_SLOTS > 32
+#error "CMSC_MAX_EXTENSION_SLOTS cannot exceed bits in `extensions_mask`"
+#endif
+
+// Decoded value of header registered with cmsc_register_header.
+struct cmsc_SipHeaderExtension {
+  // Raw value of last occurrence
+  struct cmsc_BString value;
+  // Owned by registered decoder, released by its destroy_func
+  void *data;
+};
+
+// Slot of `sip_headers` index, empty if `first` is NULL.
+struct cmsc_SipHeadersIndexSlot {
+  uint32_t hash;
+  struct cmsc_SipHeader *first;
+  struct cmsc_SipHeader *last;
+};
+
+/* Pass-through generation needs table of parsed lines, which is allocated for
+   every parsed message. Builds defining CMSC_WITH_PASS_THROUGH=0, which is
+   what meson option `pass_through` does, drop the table and always encode. */
+#ifndef CMSC_WITH_PASS_THROUGH
+#define CMSC_WITH_PASS_THROUGH 1
+#endif
+
+/* Line of parsed message with trailing CRLF, `field` is supported header
+   decoded from the line or NONE for generic and extension headers. */
+struct cmsc_SipLine {
+  uint32_t offset;
+  uint32_t len;
+  uint32_t field;
+};
+
 struct cmsc_SipMessage {
   uint32_t presence_mask;
+  /* Fields modified since parsing, with `is_pass_through` only these are
+     encoded again while other lines are copied from parsed message. Insert
+     functions mark fields dirty, users modifying fields directly use
+     cmsc_sipmsg_mark_field_dirty. */
+  uint32_t dirty_mask;
   struct cmsc_SipRequestLine request_line;
   struct cmsc_SipStatusLine status_line;
   // Supported headers start
-  struct cmsc_SipHeaderTo to;
-  struct cmsc_SipHeaderFrom from;
-  struct cmsc_SipHeaderCSeq cseq;
-  struct cmsc_BString call_id;
-  uint32_t max_forwards;
-  struct cmsc_SipViasList vias;
-  uint32_t content_length;
+#define CMSC_X(id, suffix, field, type, ...) type field;
+  CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
   // Supported headers end
+  uint32_t extensions_mask;
+  struct cmsc_SipHeaderExtension extensions[CMSC_MAX_EXTENSION_SLOTS];
   struct cmsc_SipHeadersList sip_headers;
+#if CMSC_WITH_HEADERS_INDEX
+  /* Built on first lookup, sized so it is at most half full. It is dropped
+     and built again if inserted header does not fit. */
+  struct cmsc_SipHeadersIndexSlot *_headers_index;
+  uint32_t _headers_index_size;
+  uint32_t _headers_index_len;
+#endif
   struct cmsc_BString body;
+  // Generate compact header names and separators, RFC 3261 7.3.3
+  bool is_compact_form;
+#if CMSC_WITH_PASS_THROUGH
+  /* Copy unmodified lines of parsed message instead of encoding them. Off by
+     default, as fields edited directly are then generated only if they are
+     marked with cmsc_sipmsg_mark_field_dirty. */
+  bool is_pass_through;
+  // Sized to lines of parsed message, NULL for messages built from scratch
+  struct cmsc_SipLine *_lines;
+  uint32_t _lines_len;
+  uint32_t _lines_size;
+  // Extensions changed, message is fully generated
+  bool _is_lines_invalid;
+#endif
+  // Buffer given to cmsc_parse_sip, `_buf` is its copy after first insert
+  const char *_parsed_buf;
   struct cmsc_Buffer _buf;
 };
 
@@ -134,6 +395,248 @@ cme_error_t cmsc_parse_sip(uint32_t buf_len, const char *buf,
                            struct cmsc_SipMessage **msg);
 void cmsc_sipmsg_destroy(struct cmsc_SipMessage **msg);
 
+/* Resolving is optional, it converts numeric `received`/`rport` or `sent-by`
+   of each via into `route_addr`. Vias with hostnames are left unresolved. */
+cme_error_t cmsc_resolve_sip_vias(struct cmsc_SipMessage *msg);
+
+/******************************************************************************
+ *                             Extensions                                     *
+ ******************************************************************************/
+/* Registered headers are decoded into `msg->extensions[slot]` instead of
+   landing in `msg->sip_headers`. Lookup is done in hash table built in
+   cmsc_init, so headers have to be registered after cmsc_init. `name` is not
+   copied and has to outlive registration. */
+struct cmsc_HeaderCodec {
+  const char *name;
+  uint32_t slot;
+  // Called for each occurrence of header, NULL keeps only raw value
+  cme_error_t (*decode_func)(const struct cmsc_SipHeader *sip_header,
+                             struct cmsc_SipMessage *msg,
+                             struct cmsc_SipHeaderExtension *extension);
+  // Sets header value to generate, NULL generates raw value. Can be called more
+  // than once per generated message so it should not have side effects.
+  cme_error_t (*encode_func)(const struct cmsc_SipMessage *msg,
+                             const struct cmsc_SipHeaderExtension *extension,
+                             struct cmsc_String *value);
+  // Called on message destruction, may be NULL
+  void (*destroy_func)(struct cmsc_SipHeaderExtension *extension);
+};
+
+cme_error_t cmsc_register_header(const struct cmsc_HeaderCodec *codec);
+
+cme_error_t cmsc_sipmsg_insert_extension(uint32_t slot, void *data,
+                                         struct cmsc_SipMessage *msg);
+
+/******************************************************************************
+ *                             SDP                                            *
+ ******************************************************************************/
+/* SDP is parsed into fixed size tables, nothing is allocated. All strings are
+   offsets into sip message buffer, just like in cmsc_SipMessage. */
+#ifndef CMSC_SDP_MAX_MEDIAS
+#define CMSC_SDP_MAX_MEDIAS 8
+#endif
+
+#ifndef CMSC_SDP_MAX_RTPMAPS
+#define CMSC_SDP_MAX_RTPMAPS 16
+#endif
+
+#ifndef CMSC_SDP_MAX_FMTPS
+#define CMSC_SDP_MAX_FMTPS 16
+#endif
+
+#ifndef CMSC_SDP_MAX_CANDIDATES
+#define CMSC_SDP_MAX_CANDIDATES 8
+#endif
+
+#ifndef CMSC_SDP_MAX_ATTRIBUTES
+#define CMSC_SDP_MAX_ATTRIBUTES 16
+#endif
+
+enum cmsc_SdpDirections {
+  cmsc_SdpDirections_NONE = 0,
+  cmsc_SdpDirections_SENDRECV,
+  cmsc_SdpDirections_SENDONLY,
+  cmsc_SdpDirections_RECVONLY,
+  cmsc_SdpDirections_INACTIVE,
+};
+
+struct cmsc_SdpOrigin {
+  struct cmsc_BString username;
+  struct cmsc_BString session_id;
+  struct cmsc_BString session_version;
+  struct cmsc_BString net_type;
+  struct cmsc_BString addr_type;
+  struct cmsc_BString address;
+};
+
+struct cmsc_SdpConnection {
+  struct cmsc_BString net_type;
+  struct cmsc_BString addr_type;
+  struct cmsc_BString address;
+};
+
+struct cmsc_SdpTiming {
+  struct cmsc_BString start;
+  struct cmsc_BString stop;
+};
+
+struct cmsc_SdpRtpMap {
+  uint32_t payload_type;
+  uint32_t clock_rate;
+  struct cmsc_BString encoding;
+  struct cmsc_BString encoding_params;
+};
+
+struct cmsc_SdpFmtp {
+  uint32_t payload_type;
+  struct cmsc_BString params;
+};
+
+struct cmsc_SdpCandidate {
+  struct cmsc_BString foundation;
+  uint32_t component;
+  struct cmsc_BString transport;
+  uint32_t priority;
+  struct cmsc_BString address;
+  uint32_t port;
+  struct cmsc_BString type;
+};
+
+struct cmsc_SdpAttribute {
+  struct cmsc_BString name;
+  struct cmsc_BString value;
+};
+
+struct cmsc_SdpMedia {
+  struct cmsc_BString media;
+  uint32_t port;
+  uint32_t ports_count;
+  struct cmsc_BString proto;
+  struct cmsc_BString formats;
+  struct cmsc_SdpConnection connection;
+  // Inherited from session if media does not set it
+  enum cmsc_SdpDirections direction;
+  uint32_t rtcp_port;
+  struct cmsc_SdpConnection rtcp_connection;
+  uint32_t rtpmaps_len;
+  struct cmsc_SdpRtpMap rtpmaps[CMSC_SDP_MAX_RTPMAPS];
+  uint32_t fmtps_len;
+  struct cmsc_SdpFmtp fmtps[CMSC_SDP_MAX_FMTPS];
+  uint32_t candidates_len;
+  struct cmsc_SdpCandidate candidates[CMSC_SDP_MAX_CANDIDATES];
+  // Attributes not decoded above
+  uint32_t attributes_len;
+  struct cmsc_SdpAttribute attributes[CMSC_SDP_MAX_ATTRIBUTES];
+};
+
+struct cmsc_SdpSession {
+  uint32_t version;
+  struct cmsc_SdpOrigin origin;
+  struct cmsc_BString session_name;
+  struct cmsc_SdpConnection connection;
+  struct cmsc_SdpTiming timing;
+  enum cmsc_SdpDirections direction;
+  uint32_t attributes_len;
+  struct cmsc_SdpAttribute attributes[CMSC_SDP_MAX_ATTRIBUTES];
+  uint32_t medias_len;
+  struct cmsc_SdpMedia medias[CMSC_SDP_MAX_MEDIAS];
+};
+
+cme_error_t cmsc_parse_sdp(struct cmsc_SipMessage *msg,
+                           struct cmsc_SdpSession *sdp);
+
+/******************************************************************************
+ *                             Multipart                                      *
+ ******************************************************************************/
+/* Multipart body is split according to `boundary` of Content-Type header.
+   Parts are offsets into sip message buffer, nothing is copied. */
+#ifndef CMSC_MULTIPART_MAX_PARTS
+#define CMSC_MULTIPART_MAX_PARTS 8
+#endif
+
+struct cmsc_MultipartPart {
+  // Raw part headers without trailing empty line, may be empty
+  struct cmsc_BString headers;
+  struct cmsc_BString body;
+  // Media type is NONE if part has no Content-Type
+  struct cmsc_SipHeaderContentType content_type;
+};
+
+struct cmsc_MultipartBody {
+  uint32_t parts_len;
+  struct cmsc_MultipartPart parts[CMSC_MULTIPART_MAX_PARTS];
+};
+
+cme_error_t cmsc_parse_multipart(struct cmsc_SipMessage *msg,
+                                 struct cmsc_MultipartBody *multipart);
+
+/******************************************************************************
+ *                             PIDF                                           *
+ ******************************************************************************/
+/* PIDF (RFC 3863) and RPID (RFC 4480) bodies are scanned without building
+   a tree and without allocation. Namespace prefixes are ignored, entities and
+   DTDs are not expanded, so text is returned raw as in the message. */
+#ifndef CMSC_PIDF_MAX_TUPLES
+#define CMSC_PIDF_MAX_TUPLES 8
+#endif
+
+#ifndef CMSC_PIDF_MAX_ACTIVITIES
+#define CMSC_PIDF_MAX_ACTIVITIES 8
+#endif
+
+#ifndef CMSC_PIDF_MAX_DEPTH
+#define CMSC_PIDF_MAX_DEPTH 16
+#endif
+
+struct cmsc_PidfTuple {
+  struct cmsc_BString id;
+  // Usually `open` or `closed`
+  struct cmsc_BString basic;
+  struct cmsc_BString contact;
+  struct cmsc_BString note;
+};
+
+struct cmsc_PidfPresence {
+  struct cmsc_BString entity;
+  // Note of presence or person element
+  struct cmsc_BString note;
+  uint32_t tuples_len;
+  struct cmsc_PidfTuple tuples[CMSC_PIDF_MAX_TUPLES];
+  // Local names of person activities, like `away` or `on-the-phone`
+  uint32_t activities_len;
+  struct cmsc_BString activities[CMSC_PIDF_MAX_ACTIVITIES];
+};
+
+cme_error_t cmsc_parse_pidf(struct cmsc_SipMessage *msg,
+                            struct cmsc_PidfPresence *pidf);
+
+/******************************************************************************
+ *                             Derive                                         *
+ ******************************************************************************/
+/* Creates response to `req` with Via, From, To, Call-ID and CSeq of request,
+   RFC 3261 8.2.6. Response buffer is single copy of request headers, so these
+   fields keep offsets of request and their parsed lines are generated as is.
+   `to_tag` is appended to To only if request has no To tag, 100 Trying may
+   pass none. Response owns its buffer, destroy it with
+   cmsc_sipmsg_destroy_with_buf. */
+cme_error_t cmsc_make_response(const struct cmsc_SipMessage *req,
+                               uint32_t status_code, uint32_t reason_phrase_len,
+                               const char *reason_phrase, uint32_t to_tag_len,
+                               const char *to_tag,
+                               struct cmsc_SipMessage **resp);
+
+/* Creates CANCEL of `req`, RFC 3261 9.1. Request-URI, top Via, From, To,
+   Call-ID, CSeq number, Route and Max-Forwards are shared with `req` like in
+   cmsc_make_response, only method of request line and CSeq is changed. */
+cme_error_t cmsc_make_cancel(const struct cmsc_SipMessage *req,
+                             struct cmsc_SipMessage **cancel);
+
+/* Creates ACK of non-2xx final response `resp` to `invite`, RFC 3261
+   17.1.1.3. It is built like CANCEL, To gets tag of `resp`. */
+cme_error_t cmsc_make_ack(const struct cmsc_SipMessage *invite,
+                          const struct cmsc_SipMessage *resp,
+                          struct cmsc_SipMessage **ack);
+
 /******************************************************************************
  *                             Generate                                       *
  ******************************************************************************/
@@ -159,6 +662,22 @@ cme_error_t cmsc_sipmsg_insert_header(uint32_t key_len, const char *key,
                                       uint32_t value_len, const char *value,
                                       struct cmsc_SipMessage *msg);
 
+/* Headers which are not decoded stay in `msg->sip_headers`, first lookup
+   indexes them by header id so next lookups do not walk the list. Compact
+   names match full ones and unknown names are matched case-insensitively.
+   Returns NULL if there is no such header. */
+struct cmsc_SipHeader *cmsc_sipmsg_find_header(struct cmsc_SipMessage *msg,
+                                               const char *name);
+
+// Returns next header with the same name as `header`, NULL if it was last.
+struct cmsc_SipHeader *
+cmsc_sipmsg_next_header(struct cmsc_SipMessage *msg,
+                        const struct cmsc_SipHeader *header);
+
+#define CMSC_SIPMSG_FOREACH_HEADER(header, name, msg)                          \
+  for ((header) = cmsc_sipmsg_find_header(msg, name); (header);                \
+       (header) = cmsc_sipmsg_next_header(msg, header))
+
 cme_error_t cmsc_sipmsg_insert_to(uint32_t uri_len, const char *uri,
                                   uint32_t tag_len, const char *tag,
                                   struct cmsc_SipMessage *msg);
@@ -180,16 +699,239 @@ cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
                                    uint32_t addr_len, const char *addr,
                                    uint32_t branch_len, const char *branch,
                                    uint32_t received_len, const char *received,
-                                   uint32_t ttl, struct cmsc_SipMessage *msg);
+                                   uint32_t ttl, bool has_rport,
+                                   struct cmsc_SipMessage *msg);
+
+/* Via, Route and Record-Route are stacks, proxy prepends its own entries and
+   pops the top ones. Both are O(1), popped entry is freed and emptied list
+   drops the header. ENOENT is returned if there is nothing to pop. Route
+   `params` follow `<uri>` as header params, so loose routing `lr` belongs
+   to `uri`, RFC 3261 19.1.1. */
+cme_error_t cmsc_sipmsg_prepend_via(uint32_t proto_len, const char *proto,
+                                    uint32_t sent_by_len, const char *sent_by,
+                                    uint32_t addr_len, const char *addr,
+                                    uint32_t branch_len, const char *branch,
+                                    uint32_t received_len, const char *received,
+                                    uint32_t ttl, bool has_rport,
+                                    struct cmsc_SipMessage *msg);
+
+cme_error_t cmsc_sipmsg_pop_via(struct cmsc_SipMessage *msg);
 
 cme_error_t cmsc_sipmsg_insert_content_length(uint32_t content_length,
                                               struct cmsc_SipMessage *msg);
 
+cme_error_t cmsc_sipmsg_insert_max_forwards(uint32_t max_forwards,
+                                            struct cmsc_SipMessage *msg);
+
+/* Decrements Max-Forwards of forwarded request or sets it to 70 if request has
+   none, RFC 3261 16.6. ELOOP is returned if it is already zero, such request
+   should be answered with 483 Too Many Hops. */
+cme_error_t cmsc_sipmsg_decrement_max_forwards(struct cmsc_SipMessage *msg);
+
+#if CMSC_WITH_ROUTE
+cme_error_t cmsc_sipmsg_insert_route(uint32_t uri_len, const char *uri,
+                                     uint32_t params_len, const char *params,
+                                     struct cmsc_SipMessage *msg);
+cme_error_t cmsc_sipmsg_prepend_route(uint32_t uri_len, const char *uri,
+                                      uint32_t params_len, const char *params,
+                                      struct cmsc_SipMessage *msg);
+cme_error_t cmsc_sipmsg_pop_route(struct cmsc_SipMessage *msg);
+#endif
+
+#if CMSC_WITH_RECORD_ROUTE
+cme_error_t cmsc_sipmsg_insert_record_route(uint32_t uri_len, const char *uri,
+                                            uint32_t params_len,
+                                            const char *params,
+                                            struct cmsc_SipMessage *msg);
+cme_error_t cmsc_sipmsg_prepend_record_route(uint32_t uri_len, const char *uri,
+                                             uint32_t params_len,
+                                             const char *params,
+                                             struct cmsc_SipMessage *msg);
+cme_error_t cmsc_sipmsg_pop_record_route(struct cmsc_SipMessage *msg);
+#endif
+
+#if CMSC_WITH_CONTENT_TYPE
+cme_error_t cmsc_sipmsg_insert_content_type(uint32_t type_len, const char *type,
+                                            uint32_t params_len,
+                                            const char *params,
+                                            struct cmsc_SipMessage *msg);
+#endif
+
+#if CMSC_WITH_EVENT
+cme_error_t cmsc_sipmsg_insert_event(uint32_t package_len, const char *package,
+                                     uint32_t params_len, const char *params,
+                                     struct cmsc_SipMessage *msg);
+#endif
+
+#if CMSC_WITH_SUBSCRIPTION_STATE
+cme_error_t cmsc_sipmsg_insert_subscription_state(uint32_t state_len,
+                                                  const char *state,
+                                                  uint32_t params_len,
+                                                  const char *params,
+                                                  struct cmsc_SipMessage *msg);
+#endif
+
+#if CMSC_WITH_EXPIRES
+cme_error_t cmsc_sipmsg_insert_expires(uint32_t expires,
+                                       struct cmsc_SipMessage *msg);
+#endif
+
+#if CMSC_WITH_MIN_EXPIRES
+cme_error_t cmsc_sipmsg_insert_min_expires(uint32_t min_expires,
+                                           struct cmsc_SipMessage *msg);
+#endif
+
 cme_error_t cmsc_sipmsg_insert_body(const uint32_t body_len, const char *body,
                                     struct cmsc_SipMessage *msg);
 
+/* Parsed message with `is_pass_through` is generated by copying its original
+   lines, only fields in `dirty_mask` are encoded again in place of their first
+   line. Dropped fields are skipped and new fields and generic headers follow
+   original lines. Other messages are encoded field by field.
+
+   Generated `buf` is NUL terminated and it has to be freed by caller. */
 cme_error_t cmsc_generate_sip(const struct cmsc_SipMessage *msg,
                               uint32_t *buf_len, const char **buf);
+/* Sets `size` to length of message generated by cmsc_generate_sip, message is
+   encoded without being written to measure it. */
+cme_error_t cmsc_generate_sip_size(const struct cmsc_SipMessage *msg,
+                                   uint32_t *size);
+/* Generates message into caller owned `dst`, without terminating NUL. If `cap`
+   is too small ENOBUFS is returned and `len` is set to required size. */
+cme_error_t cmsc_generate_sip_into(const struct cmsc_SipMessage *msg,
+                                   char *dst, uint32_t cap, uint32_t *len);
+/* Generates message as iovecs for writev or sendmsg. Iovecs point into `msg`
+   buffer for values stored there, like uris, tags or body, and into `scratch`
+   for the rest. Scratch of cmsc_generate_sip_size bytes is always enough.
+   Iovecs are valid until `msg` is modified or destroyed. */
+cme_error_t cmsc_generate_sip_iov(const struct cmsc_SipMessage *msg,
+                                  char *scratch, uint32_t scratch_cap,
+                                  struct iovec *iov, uint32_t iov_cap,
+                                  uint32_t *iov_len);
+
+/******************************************************************************
+ *                             Template                                       *
+ ******************************************************************************/
+#ifndef CMSC_TEMPLATE_MAX_SLOTS
+#define CMSC_TEMPLATE_MAX_SLOTS 16
+#endif
+
+// Place in template text where value of `names[name]` is inserted.
+struct cmsc_TemplateSlot {
+  uint32_t offset;
+  uint32_t name;
+};
+
+/* Message serialized once with `${name}` placeholders, like `${branch}`,
+   `${to_tag}` or `${cseq}`. Placeholders are cut out of the text and their
+   offsets recorded, so each instance costs copy of the text plus values.
+   Placeholder with the same name may occur more than once. */
+struct cmsc_Template {
+  // Text without placeholders, names are stored behind space reserved for it
+  struct cmsc_Buffer _buf;
+  uint32_t _text_len;
+  // Names in order of first occurrence, values are given in this order
+  struct cmsc_BString names[CMSC_TEMPLATE_MAX_SLOTS];
+  uint32_t names_len;
+  struct cmsc_TemplateSlot _slots[CMSC_TEMPLATE_MAX_SLOTS];
+  uint32_t _slots_len;
+};
+
+cme_error_t cmsc_template_create(uint32_t buf_len, const char *buf,
+                                 struct cmsc_Template **tmpl);
+/* Generates `msg` and creates template from it, placeholders are inserted as
+   values. Numeric fields like CSeq number can be templated only by inserting
+   whole header with cmsc_sipmsg_insert_header. */
+cme_error_t cmsc_template_create_from_sip(const struct cmsc_SipMessage *msg,
+                                          struct cmsc_Template **tmpl);
+void cmsc_template_destroy(struct cmsc_Template **tmpl);
+
+// Sets `index` of value for placeholder `name`, ENOENT if there is none.
+cme_error_t cmsc_template_find(const struct cmsc_Template *tmpl,
+                               const char *name, uint32_t *index);
+
+/* Renders template into caller owned `dst` with `values` in order of
+   `tmpl->names`, without terminating NUL. If `cap` is too small ENOBUFS is
+   returned and `len` is set to required size. Content-Length is not updated,
+   template of varying body has to have placeholder for it too. */
+cme_error_t cmsc_template_render(const struct cmsc_Template *tmpl,
+                                 const struct cmsc_String *values,
+                                 uint32_t values_len, char *dst, uint32_t cap,
+                                 uint32_t *len);
+
+/* Fan-out of template, like forking to several contacts or NOTIFY broadcast.
+   `count` instances are rendered one after another into `dst`, values of
+   instance `i` start at `values[i * values_len]` and its length is set in
+   `lens[i]`. If `cap` is too small ENOBUFS is returned and nothing is
+   rendered, `lens` holds required sizes then. */
+cme_error_t cmsc_template_render_many(const struct cmsc_Template *tmpl,
+                                      const struct cmsc_String *values,
+                                      uint32_t values_len, uint32_t count,
+                                      char *dst, uint32_t cap, uint32_t *lens);
+
+// Iovecs needed by cmsc_template_render_iov in the worst case.
+#define CMSC_TEMPLATE_IOV_MAX (CMSC_TEMPLATE_MAX_SLOTS * 2 + 1)
+
+/* Renders template as iovecs for writev or sendmsg without copying, iovecs
+   point into template text and `values`. Each instance of fan-out needs only
+   its own iovecs, shared text is referenced by all of them. */
+cme_error_t cmsc_template_render_iov(const struct cmsc_Template *tmpl,
+                                     const struct cmsc_String *values,
+                                     uint32_t values_len, struct iovec *iov,
+                                     uint32_t iov_cap, uint32_t *iov_len);
+
+/******************************************************************************
+ *                             Builder                                        *
+ ******************************************************************************/
+/* Writes wire format straight into caller owned buffer, without creating
+   cmsc_SipMessage. Message is begun with request or status line, followed by
+   headers and body. Content-Length is written by builder, its value is
+   reserved before the body and patched in cmsc_builder_finish. Part which
+   does not fit returns ENOBUFS and leaves builder unchanged. */
+struct cmsc_Builder {
+  char *_dst;
+  uint32_t _cap;
+  uint32_t _len;
+  // Zero until body is started
+  uint32_t _body_offset;
+  // Space reserved for Content-Length value, right before its CRLF
+  uint32_t _content_length_offset;
+  uint32_t _content_length_width;
+  bool _is_finished;
+};
+
+cme_error_t cmsc_builder_init(char *dst, uint32_t cap,
+                              struct cmsc_Builder *builder);
+
+cme_error_t cmsc_builder_begin_request(uint32_t method_len, const char *method,
+                                       uint32_t req_uri_len,
+                                       const char *req_uri,
+                                       struct cmsc_Builder *builder);
+
+cme_error_t cmsc_builder_begin_response(uint32_t status_code,
+                                        uint32_t reason_phrase_len,
+                                        const char *reason_phrase,
+                                        struct cmsc_Builder *builder);
+
+cme_error_t cmsc_builder_add_via(uint32_t proto_len, const char *proto,
+                                 uint32_t sent_by_len, const char *sent_by,
+                                 uint32_t branch_len, const char *branch,
+                                 struct cmsc_Builder *builder);
+
+// Content-Length is written by builder, so it is rejected with EINVAL.
+cme_error_t cmsc_builder_add_header(uint32_t name_len, const char *name,
+                                    uint32_t value_len, const char *value,
+                                    struct cmsc_Builder *builder);
+
+/* Appends `body`, it can be called more than once. First call ends headers,
+   so no header can be added after it. Content-Length value is padded with
+   spaces to width of space left in buffer. */
+cme_error_t cmsc_builder_set_body(uint32_t body_len, const char *body,
+                                  struct cmsc_Builder *builder);
+
+/* Patches Content-Length, or writes zero one if there is no body. Builder
+   cannot be modified afterwards. */
+cme_error_t cmsc_builder_finish(struct cmsc_Builder *builder, uint32_t *len);
 
 static inline struct cmsc_String
 cmsc_bs_msg_to_string(const struct cmsc_BString *src,
@@ -204,4 +946,34 @@ cmsc_sipmsg_is_field_present(struct cmsc_SipMessage *msg,
   return msg->presence_mask & header_id;
 }
 
+static inline void
+cmsc_sipmsg_mark_field_dirty(struct cmsc_SipMessage *msg,
+                             enum cmsc_SupportedSipHeaders header_id) {
+  msg->dirty_mask = msg->dirty_mask | header_id;
+}
+
+static inline struct cmsc_SipHeaderExtension *
+cmsc_sipmsg_get_extension(struct cmsc_SipMessage *msg, uint32_t slot) {
+  if (slot >= CMSC_MAX_EXTENSION_SLOTS ||
+      !(msg->extensions_mask & (1u << slot))) {
+    return NULL;
+  }
+
+  return &msg->extensions[slot];
+}
+
+static inline bool
+cmsc_sip_tokens_has_all(const struct cmsc_SipHeaderTokens *tokens,
+                        uint32_t mask) {
+  return (tokens->mask & mask) == mask;
+}
+
+/* Returns required option tags missing in `supported_mask`. Unknown required
+   tags are never supported, so non empty `unknown` also means 420. */
+static inline uint32_t
+cmsc_sip_tokens_unsupported(const struct cmsc_SipHeaderTokens *required,
+                            uint32_t supported_mask) {
+  return required->mask & ~supported_mask;
+}
+
 #endif
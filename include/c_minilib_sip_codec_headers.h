@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_HEADERS_H
+#define C_MINILIB_SIP_CODEC_HEADERS_H
+
+/******************************************************************************
+ *                             Supported headers                              *
+ ******************************************************************************/
+/* Single list of supported headers. Presence bits, cmsc_SipMessage fields,
+   decoders and encoders are all generated from it, so adding header means
+   adding one line here plus its decode and encode functions named
+   cmsc_decode_func_<suffix> and cmsc_encode_hdr_<suffix>.
+
+   Headers mandatory according RFC 3261 8.1.1 and Content-Length, which frames
+   the body, are always compiled in. Optional headers can be stripped by
+   defining CMSC_HEADERS_SELECTED together with CMSC_WITH_<ID>=1 for each
+   header to keep, which is what meson option `headers` does. */
+#ifdef CMSC_HEADERS_SELECTED
+#define CMSC_WITH_DEFAULT 0
+#else
+#define CMSC_WITH_DEFAULT 1
+#endif
+
+#ifndef CMSC_WITH_ROUTE
+#define CMSC_WITH_ROUTE CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_RECORD_ROUTE
+#define CMSC_WITH_RECORD_ROUTE CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_ALLOW
+#define CMSC_WITH_ALLOW CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_SUPPORTED
+#define CMSC_WITH_SUPPORTED CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_REQUIRE
+#define CMSC_WITH_REQUIRE CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_PROXY_REQUIRE
+#define CMSC_WITH_PROXY_REQUIRE CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_UNSUPPORTED
+#define CMSC_WITH_UNSUPPORTED CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_CONTENT_TYPE
+#define CMSC_WITH_CONTENT_TYPE CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_EVENT
+#define CMSC_WITH_EVENT CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_SUBSCRIPTION_STATE
+#define CMSC_WITH_SUBSCRIPTION_STATE CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_EXPIRES
+#define CMSC_WITH_EXPIRES CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_MIN_EXPIRES
+#define CMSC_WITH_MIN_EXPIRES CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_P_ASSERTED_IDENTITY
+#define CMSC_WITH_P_ASSERTED_IDENTITY CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_P_PREFERRED_IDENTITY
+#define CMSC_WITH_P_PREFERRED_IDENTITY CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_DIVERSION
+#define CMSC_WITH_DIVERSION CMSC_WITH_DEFAULT
+#endif
+#ifndef CMSC_WITH_HISTORY_INFO
+#define CMSC_WITH_HISTORY_INFO CMSC_WITH_DEFAULT
+#endif
+
+// CMSC_IF(1)(x) expands to x, CMSC_IF(0)(x) expands to nothing.
+#define CMSC_IF(cond) CMSC_IF_CAT(CMSC_IF_, cond)
+#define CMSC_IF_CAT(a, b) CMSC_IF_CAT_(a, b)
+#define CMSC_IF_CAT_(a, b) a##b
+#define CMSC_IF_0(...)
+#define CMSC_IF_1(...) __VA_ARGS__
+
+/* X(id, suffix, field, type, name, compact_name, is_encoded)
+     id           - cmsc_SupportedSipHeaders_<id> presence bit
+     suffix       - decoder and encoder functions suffix
+     field        - cmsc_SipMessage field of `type`
+     name         - header name
+     compact_name - RFC 3261 7.3.3 compact form, "" if header has none
+     is_encoded   - 0 if header is decoded but not generated yet
+   Order of the list is order of generated headers. Headers described in
+   scripts/headers.abnf are appended by CMSC_GENERATED_SIP_HEADERS, which
+   comes from build-time generated c_minilib_sip_codec_generated.h. */
+#define CMSC_SIP_HEADERS(X)                                                    \
+  X(VIAS, via, vias, struct cmsc_SipViasList, "Via", "v", 1)                   \
+  X(TO, to, to, struct cmsc_SipHeaderTo, "To", "t", 1)                         \
+  X(FROM, from, from, struct cmsc_SipHeaderFrom, "From", "f", 1)               \
+  X(CALL_ID, call_id, call_id, struct cmsc_BString, "Call-ID", "i", 1)         \
+  X(CSEQ, cseq, cseq, struct cmsc_SipHeaderCSeq, "CSeq", "", 1)                \
+  X(CONTENT_LENGTH, content_length, content_length, uint32_t,                  \
+    "Content-Length", "l", 1)                                                  \
+  X(MAX_FORWARDS, max_forwards, max_forwards, uint32_t, "Max-Forwards", "", 1) \
+  CMSC_IF(CMSC_WITH_ROUTE)(X(ROUTE, route, routes, struct cmsc_SipRoutesList,  \
+                             "Route", "", 1))                                  \
+  CMSC_IF(CMSC_WITH_RECORD_ROUTE)(X(RECORD_ROUTE, record_route, record_routes, \
+                                    struct cmsc_SipRoutesList, "Record-Route", \
+                                    "", 1))                                    \
+  CMSC_IF(CMSC_WITH_ALLOW)(X(ALLOW, allow, allow, struct cmsc_SipHeaderTokens, \
+                             "Allow", "", 1))                                  \
+  CMSC_IF(CMSC_WITH_SUPPORTED)(X(SUPPORTED, supported, supported,              \
+                                 struct cmsc_SipHeaderTokens, "Supported",     \
+                                 "k", 1))                                      \
+  CMSC_IF(CMSC_WITH_REQUIRE)(X(REQUIRE, require, require,                      \
+                               struct cmsc_SipHeaderTokens, "Require", "", 1)) \
+  CMSC_IF(CMSC_WITH_PROXY_REQUIRE)(X(PROXY_REQUIRE, proxy_require,             \
+                                     proxy_require,                            \
+                                     struct cmsc_SipHeaderTokens,              \
+                                     "Proxy-Require", "", 1))                  \
+  CMSC_IF(CMSC_WITH_UNSUPPORTED)(X(UNSUPPORTED, unsupported, unsupported,      \
+                                   struct cmsc_SipHeaderTokens, "Unsupported", \
+                                   "", 1))                                     \
+  CMSC_IF(CMSC_WITH_CONTENT_TYPE)(X(CONTENT_TYPE, content_type, content_type,  \
+                                    struct cmsc_SipHeaderContentType,          \
+                                    "Content-Type", "c", 1))                   \
+  CMSC_IF(CMSC_WITH_EVENT)(X(EVENT, event, event, struct cmsc_SipHeaderEvent,  \
+                             "Event", "o", 1))                                 \
+  CMSC_IF(CMSC_WITH_SUBSCRIPTION_STATE)(X(                                     \
+      SUBSCRIPTION_STATE, subscription_state, subscription_state,              \
+      struct cmsc_SipHeaderSubscriptionState, "Subscription-State", "", 1))    \
+  CMSC_IF(CMSC_WITH_EXPIRES)(X(EXPIRES, expires, expires, uint32_t, "Expires", \
+                               "", 1))                                         \
+  CMSC_IF(CMSC_WITH_MIN_EXPIRES)(X(MIN_EXPIRES, min_expires, min_expires,      \
+                                   uint32_t, "Min-Expires", "", 1))            \
+  CMSC_IF(CMSC_WITH_P_ASSERTED_IDENTITY)(X(                                    \
+      P_ASSERTED_IDENTITY, p_asserted_identity, p_asserted_identities,         \
+      struct cmsc_SipIdentitiesList, "P-Asserted-Identity", "", 1))            \
+  CMSC_IF(CMSC_WITH_P_PREFERRED_IDENTITY)(X(                                   \
+      P_PREFERRED_IDENTITY, p_preferred_identity, p_preferred_identities,      \
+      struct cmsc_SipIdentitiesList, "P-Preferred-Identity", "", 1))           \
+  CMSC_IF(CMSC_WITH_DIVERSION)(X(DIVERSION, diversion, diversions,             \
+                                 struct cmsc_SipDiversionsList, "Diversion",   \
+                                 "", 1))                                       \
+  CMSC_IF(CMSC_WITH_HISTORY_INFO)(X(HISTORY_INFO, history_info, history_infos, \
+                                    struct cmsc_SipHistoryInfosList,           \
+                                    "History-Info", "", 1))                    \
+  CMSC_GENERATED_SIP_HEADERS(X)
+
+/******************************************************************************
+ *                             Header names                                   *
+ ******************************************************************************/
+/* Header names registered in IANA SIP parameters registry, along with their
+   RFC 3261 7.3.3 compact forms. Every cmsc_SipHeader gets id of its name when
+   it is split, so consumers can switch on cmsc_HeaderNames instead of
+   comparing strings. X(id, name, compact_name) */
+#define CMSC_HEADER_NAMES(X)                                                   \
+  X(ACCEPT, "Accept", "")                                                      \
+  X(ACCEPT_CONTACT, "Accept-Contact", "a")                                     \
+  X(ACCEPT_ENCODING, "Accept-Encoding", "")                                    \
+  X(ACCEPT_LANGUAGE, "Accept-Language", "")                                    \
+  X(ACCEPT_RESOURCE_PRIORITY, "Accept-Resource-Priority", "")                  \
+  X(ALERT_INFO, "Alert-Info", "")                                              \
+  X(ALLOW, "Allow", "")                                                        \
+  X(ALLOW_EVENTS, "Allow-Events", "u")                                         \
+  X(ANSWER_MODE, "Answer-Mode", "")                                            \
+  X(AUTHENTICATION_INFO, "Authentication-Info", "")                            \
+  X(AUTHORIZATION, "Authorization", "")                                        \
+  X(CALL_ID, "Call-ID", "i")                                                   \
+  X(CALL_INFO, "Call-Info", "")                                                \
+  X(CONTACT, "Contact", "m")                                                   \
+  X(CONTENT_DISPOSITION, "Content-Disposition", "")                            \
+  X(CONTENT_ENCODING, "Content-Encoding", "e")                                 \
+  X(CONTENT_ID, "Content-ID", "")                                              \
+  X(CONTENT_LANGUAGE, "Content-Language", "")                                  \
+  X(CONTENT_LENGTH, "Content-Length", "l")                                     \
+  X(CONTENT_TYPE, "Content-Type", "c")                                         \
+  X(CSEQ, "CSeq", "")                                                          \
+  X(DATE, "Date", "")                                                          \
+  X(DIVERSION, "Diversion", "")                                                \
+  X(ERROR_INFO, "Error-Info", "")                                              \
+  X(EVENT, "Event", "o")                                                       \
+  X(EXPIRES, "Expires", "")                                                    \
+  X(FEATURE_CAPS, "Feature-Caps", "")                                          \
+  X(FLOW_TIMER, "Flow-Timer", "")                                              \
+  X(FROM, "From", "f")                                                         \
+  X(GEOLOCATION, "Geolocation", "")                                            \
+  X(GEOLOCATION_ERROR, "Geolocation-Error", "")                                \
+  X(GEOLOCATION_ROUTING, "Geolocation-Routing", "")                            \
+  X(HISTORY_INFO, "History-Info", "")                                          \
+  X(IDENTITY, "Identity", "y")                                                 \
+  X(IDENTITY_INFO, "Identity-Info", "n")                                       \
+  X(IN_REPLY_TO, "In-Reply-To", "")                                            \
+  X(INFO_PACKAGE, "Info-Package", "")                                          \
+  X(JOIN, "Join", "")                                                          \
+  X(MAX_BREADTH, "Max-Breadth", "")                                            \
+  X(MAX_FORWARDS, "Max-Forwards", "")                                          \
+  X(MIME_VERSION, "MIME-Version", "")                                          \
+  X(MIN_EXPIRES, "Min-Expires", "")                                            \
+  X(MIN_SE, "Min-SE", "")                                                      \
+  X(ORGANIZATION, "Organization", "")                                          \
+  X(P_ACCESS_NETWORK_INFO, "P-Access-Network-Info", "")                        \
+  X(P_ANSWER_STATE, "P-Answer-State", "")                                      \
+  X(P_ASSERTED_IDENTITY, "P-Asserted-Identity", "")                            \
+  X(P_ASSERTED_SERVICE, "P-Asserted-Service", "")                              \
+  X(P_ASSOCIATED_URI, "P-Associated-URI", "")                                  \
+  X(P_CALLED_PARTY_ID, "P-Called-Party-ID", "")                                \
+  X(P_CHARGING_FUNCTION_ADDRESSES, "P-Charging-Function-Addresses", "")        \
+  X(P_CHARGING_VECTOR, "P-Charging-Vector", "")                                \
+  X(P_DCS_BILLING_INFO, "P-DCS-Billing-Info", "")                              \
+  X(P_DCS_LAES, "P-DCS-LAES", "")                                              \
+  X(P_DCS_OSPS, "P-DCS-OSPS", "")                                              \
+  X(P_DCS_REDIRECT, "P-DCS-Redirect", "")                                      \
+  X(P_DCS_TRACE_PARTY_ID, "P-DCS-Trace-Party-ID", "")                          \
+  X(P_EARLY_MEDIA, "P-Early-Media", "")                                        \
+  X(P_MEDIA_AUTHORIZATION, "P-Media-Authorization", "")                        \
+  X(P_PREFERRED_IDENTITY, "P-Preferred-Identity", "")                          \
+  X(P_PREFERRED_SERVICE, "P-Preferred-Service", "")                            \
+  X(P_PRIVATE_NETWORK_INDICATION, "P-Private-Network-Indication", "")          \
+  X(P_PROFILE_KEY, "P-Profile-Key", "")                                        \
+  X(P_REFUSED_URI_LIST, "P-Refused-URI-List", "")                              \
+  X(P_SERVED_USER, "P-Served-User", "")                                        \
+  X(P_USER_DATABASE, "P-User-Database", "")                                    \
+  X(P_VISITED_NETWORK_ID, "P-Visited-Network-ID", "")                          \
+  X(PATH, "Path", "")                                                          \
+  X(PERMISSION_MISSING, "Permission-Missing", "")                              \
+  X(POLICY_CONTACT, "Policy-Contact", "")                                      \
+  X(POLICY_ID, "Policy-ID", "")                                                \
+  X(PRIORITY, "Priority", "")                                                  \
+  X(PRIV_ANSWER_MODE, "Priv-Answer-Mode", "")                                  \
+  X(PRIVACY, "Privacy", "")                                                    \
+  X(PROXY_AUTHENTICATE, "Proxy-Authenticate", "")                              \
+  X(PROXY_AUTHORIZATION, "Proxy-Authorization", "")                            \
+  X(PROXY_REQUIRE, "Proxy-Require", "")                                        \
+  X(RACK, "RAck", "")                                                          \
+  X(REASON, "Reason", "")                                                      \
+  X(RECORD_ROUTE, "Record-Route", "")                                          \
+  X(RECV_INFO, "Recv-Info", "")                                                \
+  X(REFER_EVENTS_AT, "Refer-Events-At", "")                                    \
+  X(REFER_SUB, "Refer-Sub", "")                                                \
+  X(REFER_TO, "Refer-To", "r")                                                 \
+  X(REFERRED_BY, "Referred-By", "b")                                           \
+  X(REJECT_CONTACT, "Reject-Contact", "j")                                     \
+  X(REPLACES, "Replaces", "")                                                  \
+  X(REPLY_TO, "Reply-To", "")                                                  \
+  X(REQUEST_DISPOSITION, "Request-Disposition", "d")                           \
+  X(REQUIRE, "Require", "")                                                    \
+  X(RESOURCE_PRIORITY, "Resource-Priority", "")                                \
+  X(RETRY_AFTER, "Retry-After", "")                                            \
+  X(ROUTE, "Route", "")                                                        \
+  X(RSEQ, "RSeq", "")                                                          \
+  X(SECURITY_CLIENT, "Security-Client", "")                                    \
+  X(SECURITY_SERVER, "Security-Server", "")                                    \
+  X(SECURITY_VERIFY, "Security-Verify", "")                                    \
+  X(SERVER, "Server", "")                                                      \
+  X(SERVICE_ROUTE, "Service-Route", "")                                        \
+  X(SESSION_EXPIRES, "Session-Expires", "x")                                   \
+  X(SESSION_ID, "Session-ID", "")                                              \
+  X(SIP_ETAG, "SIP-ETag", "")                                                  \
+  X(SIP_IF_MATCH, "SIP-If-Match", "")                                          \
+  X(SUBJECT, "Subject", "s")                                                   \
+  X(SUBSCRIPTION_STATE, "Subscription-State", "")                              \
+  X(SUPPORTED, "Supported", "k")                                               \
+  X(SUPPRESS_IF_MATCH, "Suppress-If-Match", "")                                \
+  X(TARGET_DIALOG, "Target-Dialog", "")                                        \
+  X(TIMESTAMP, "Timestamp", "")                                                \
+  X(TO, "To", "t")                                                             \
+  X(TRIGGER_CONSENT, "Trigger-Consent", "")                                    \
+  X(UNSUPPORTED, "Unsupported", "")                                            \
+  X(USER_AGENT, "User-Agent", "")                                              \
+  X(USER_TO_USER, "User-to-User", "")                                          \
+  X(VIA, "Via", "v")                                                           \
+  X(WARNING, "Warning", "")                                                    \
+  X(WWW_AUTHENTICATE, "WWW-Authenticate", "")
+
+#endif
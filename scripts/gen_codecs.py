@@ -0,0 +1,233 @@
+#!/usr/bin/env python3
+######################################################################################
+#                               Imports                                              #
+######################################################################################
+import argparse
+import os
+import re
+import sys
+
+######################################################################################
+#                             Configuration                                          #
+######################################################################################
+RULES = {
+    "token": "cmsc_AbnfRules_TOKEN",
+    "delta-seconds": "cmsc_AbnfRules_DELTA_SECONDS",
+    "text": "cmsc_AbnfRules_TEXT",
+}
+
+FIELD_TYPES = {
+    "token": "struct cmsc_BString",
+    "delta-seconds": "uint32_t",
+    "text": "struct cmsc_BString",
+}
+
+HEADER_RE = re.compile(r"^(?P<name>[A-Za-z][A-Za-z0-9-]*)\s*"
+                       r"(?:/\s*(?P<compact>[a-z]))?\s*=\s*(?P<rule>.+)$")
+VALUE_RE = re.compile(r"^(?P<rule>[a-z-]+):(?P<field>[a-z_][a-z0-9_]*)$")
+PARAM_RE = re.compile(r"^;(?P<param>[a-z][a-z0-9-]*)="
+                      r"(?P<rule>[a-z-]+):(?P<field>[a-z_][a-z0-9_]*)$")
+
+LICENSE = """/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+// Generated by scripts/gen_codecs.py from {spec}, do not edit.
+"""
+
+
+######################################################################################
+#                             Parsing                                                #
+######################################################################################
+class Header:
+    def __init__(self, name, compact):
+        self.name = name
+        self.compact = compact or ""
+        self.id = name.upper().replace("-", "_")
+        self.suffix = name.lower().replace("-", "_")
+        self.struct = "cmsc_SipHeader" + "".join(
+            part.capitalize() for part in name.split("-"))
+        # (param or None, rule, field)
+        self.fields = []
+        self.has_generic_params = False
+
+
+def _parse_value(header, item, line_no):
+    match = VALUE_RE.match(item)
+    if not match or match["rule"] not in RULES:
+        _die(line_no, f"invalid value `{item}`")
+    header.fields.append((None, match["rule"], match["field"]))
+
+
+def _parse_param(header, item, line_no):
+    match = PARAM_RE.match(item)
+    if not match or match["rule"] not in RULES:
+        _die(line_no, f"invalid param `{item}`")
+    if match["rule"] == "text":
+        _die(line_no, "text rule is allowed only for header value")
+    header.fields.append((match["param"], match["rule"], match["field"]))
+
+
+def parse_spec(path):
+    headers = []
+
+    with open(path) as spec:
+        for line_no, line in enumerate(spec, 1):
+            # Params start with SEMI too, so only whole lines are comments
+            line = line.strip()
+            if not line or line.startswith(";"):
+                continue
+
+            match = HEADER_RE.match(line)
+            if not match:
+                _die(line_no, f"invalid header `{line}`")
+
+            header = Header(match["name"], match["compact"])
+            items = match["rule"].split()
+            _parse_value(header, items[0], line_no)
+            for item in items[1:]:
+                if item == "*generic-param":
+                    header.has_generic_params = True
+                else:
+                    _parse_param(header, item, line_no)
+
+            if header.fields[0][1] == "text" and (
+                    header.has_generic_params or len(header.fields) > 1):
+                _die(line_no, "text value cannot have params")
+
+            fields = [field for _, _, field in header.fields]
+            if header.has_generic_params:
+                fields.append("params")
+            if len(fields) != len(set(fields)):
+                _die(line_no, "fields names have to be unique")
+
+            headers.append(header)
+
+    return headers
+
+
+######################################################################################
+#                             Generation                                             #
+######################################################################################
+def generate_public(headers, spec):
+    out = [LICENSE.format(spec=spec)]
+    out.append("#ifndef C_MINILIB_SIP_CODEC_GENERATED_H\n"
+               "#define C_MINILIB_SIP_CODEC_GENERATED_H\n\n"
+               "#include <stdint.h>\n\n")
+
+    for header in headers:
+        out.append(f"#ifndef CMSC_WITH_{header.id}\n"
+                   f"#define CMSC_WITH_{header.id} CMSC_WITH_DEFAULT\n"
+                   "#endif\n")
+    out.append("\n")
+
+    for header in headers:
+        out.append(f"struct {header.struct} {{\n")
+        for _, rule, field in header.fields:
+            out.append(f"  {FIELD_TYPES[rule]} {field};\n")
+        if header.has_generic_params:
+            out.append("  struct cmsc_BString params;\n")
+        out.append("};\n\n")
+
+    out.append("#define CMSC_GENERATED_SIP_HEADERS(X)")
+    for header in headers:
+        out.append(
+            f" \\\n  CMSC_IF(CMSC_WITH_{header.id})(X({header.id}, "
+            f"{header.suffix}, {header.suffix}, struct {header.struct}, "
+            f"\"{header.name}\", \"{header.compact}\", 1))")
+    out.append("\n\n#endif\n")
+
+    return "".join(out)
+
+
+def generate_private(headers, spec):
+    out = [LICENSE.format(spec=spec)]
+    out.append("#ifndef C_MINILIB_SIP_CODEC_GENERATED_CODECS_H\n"
+               "#define C_MINILIB_SIP_CODEC_GENERATED_CODECS_H\n\n"
+               "#include <stddef.h>\n\n"
+               "#include \"c_minilib_error.h\"\n"
+               "#include \"c_minilib_sip_codec.h\"\n"
+               "#include \"utils/abnf.h\"\n")
+
+    for header in headers:
+        out.append(f"\n#if CMSC_WITH_{header.id}\n")
+        out.append("static inline const struct cmsc_AbnfHeader *\n"
+                   f"cmsc_abnf_{header.suffix}(void) {{\n"
+                   "  static const struct cmsc_AbnfField fields[] = {\n")
+        for param, rule, field in header.fields:
+            param = f"\"{param}\"" if param else "NULL"
+            out.append(f"      {{.param = {param},\n"
+                       f"       .rule = {RULES[rule]},\n"
+                       f"       .offset = offsetof(struct {header.struct}, "
+                       f"{field})}},\n")
+        out.append("  };\n")
+
+        params_offset = (f"offsetof(struct {header.struct}, params)"
+                         if header.has_generic_params else "0")
+        out.append(
+            "  static const struct cmsc_AbnfHeader header = {\n"
+            f"      .name = \"{header.name}\",\n"
+            f"      .id = cmsc_SupportedSipHeaders_{header.id},\n"
+            f"      .offset = offsetof(struct cmsc_SipMessage, "
+            f"{header.suffix}),\n"
+            f"      .size = sizeof(struct {header.struct}),\n"
+            "      .fields = fields,\n"
+            "      .fields_len = sizeof(fields) / "
+            "sizeof(struct cmsc_AbnfField),\n"
+            "      .has_generic_params = "
+            f"{'true' if header.has_generic_params else 'false'},\n"
+            f"      .params_offset = {params_offset},\n"
+            "  };\n\n"
+            "  return &header;\n"
+            "}\n\n")
+
+        out.append(
+            "static inline cme_error_t\n"
+            f"cmsc_decode_func_{header.suffix}("
+            "const struct cmsc_SipHeader *sip_header,\n"
+            "    struct cmsc_SipMessage *msg) {\n"
+            f"  return cmsc_abnf_decode(cmsc_abnf_{header.suffix}(), "
+            "sip_header, msg);\n"
+            "}\n\n"
+            "static inline cme_error_t\n"
+            f"cmsc_encode_hdr_{header.suffix}("
+            "const struct cmsc_SipMessage *msg,\n"
+            "    struct cmsc_Writer *writer) {\n"
+            f"  return cmsc_abnf_encode(cmsc_abnf_{header.suffix}(), msg, "
+            "writer);\n"
+            "}\n")
+        out.append("#endif\n")
+
+    out.append("\n#endif\n")
+
+    return "".join(out)
+
+
+######################################################################################
+#                             Private API                                            #
+######################################################################################
+def _die(line_no, msg):
+    print(f"headers spec:{line_no}: {msg}", file=sys.stderr)
+    sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Generate table-driven header codecs from ABNF-like spec")
+    parser.add_argument("spec")
+    parser.add_argument("kind", choices=["public", "private"])
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    headers = parse_spec(args.spec)
+    spec = os.path.basename(args.spec)
+    generate = generate_public if args.kind == "public" else generate_private
+
+    with open(args.output, "w") as output:
+        output.write(generate(headers, f"scripts/{spec}"))
+
+
+if __name__ == "__main__":
+    main()
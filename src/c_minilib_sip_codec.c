@@ -18,9 +18,14 @@
 #include "utils/decoder.h"
 #include "utils/encoder.h"
 #include "utils/generator.h"
+#include "utils/multipart.h"
 #include "utils/parser.h"
+#include "utils/pidf.h"
+#include "utils/registry.h"
+#include "utils/sdp.h"
 #include "utils/sipmsg.h"
 
+// Generated message is mostly made of values kept in `msg` buffer.
 #ifndef CMSC_GENERATOR_DEFAULT_SPACE_SIZE
 #define CMSC_GENERATOR_DEFAULT_SPACE_SIZE 128
 #endif
@@ -33,13 +38,21 @@ cme_error_t cmsc_init(void) {
     goto error_out;
   };
 
+  err = cmsc_registry_init();
+  if (err) {
+    goto error_out;
+  }
+
   return 0;
 
 error_out:
   return cme_return(err);
 };
 
-void cmsc_destroy(void) { cme_destroy(); };
+void cmsc_destroy(void) {
+  cmsc_registry_destroy();
+  cme_destroy();
+};
 
 cme_error_t cmsc_parse_sip(uint32_t buf_len, const char *buf,
                            struct cmsc_SipMessage **msg) {
@@ -49,6 +62,12 @@ cme_error_t cmsc_parse_sip(uint32_t buf_len, const char *buf,
     goto error_out;
   }
 
+  // Without registry no header would be decoded
+  if (!cmsc_registry_is_ready()) {
+    err = cme_error(EINVAL, "cmsc_init has to be called first");
+    goto error_out;
+  }
+
   err = cmsc_sipmsg_create(
       (struct cmsc_Buffer){.buf = buf, .len = buf_len, .size = buf_len}, msg);
   if (err) {
@@ -60,12 +79,31 @@ cme_error_t cmsc_parse_sip(uint32_t buf_len, const char *buf,
   if (err) {
     goto error_sipmsg_cleanup;
   }
+  uint32_t first_line_end = parse_buf.buf - buf;
 
   err = cmsc_parse_sip_headers(&parse_buf, (*msg));
   if (err) {
     goto error_sipmsg_cleanup;
   }
 
+#if CMSC_WITH_PASS_THROUGH
+  // First line and every header line are recorded while decoding
+  uint32_t lines_size = 1;
+  struct cmsc_SipHeader *header;
+  STAILQ_FOREACH(header, &(*msg)->sip_headers, _next) { lines_size++; }
+
+  err = cmsc_sipmsg_create_lines(lines_size, (*msg));
+  if (err) {
+    goto error_sipmsg_cleanup;
+  }
+#endif
+
+  // Request and status line are generated by the same first line
+  cmsc_sipmsg_record_line(0, first_line_end,
+                          cmsc_SupportedSipHeaders_REQUEST_LINE |
+                              cmsc_SupportedSipHeaders_STATUS_LINE,
+                          (*msg));
+
   err = cmsc_decode_sip_headers((*msg));
   if (err) {
     goto error_sipmsg_cleanup;
@@ -76,6 +114,9 @@ cme_error_t cmsc_parse_sip(uint32_t buf_len, const char *buf,
     goto error_sipmsg_cleanup;
   }
 
+  (*msg)->dirty_mask = 0;
+  (*msg)->_parsed_buf = buf;
+
   return 0;
 error_sipmsg_cleanup:
   cmsc_sipmsg_destroy(msg);
@@ -83,6 +124,108 @@ error_out:
   return cme_return(err);
 }
 
+cme_error_t cmsc_resolve_sip_vias(struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+  if (!msg) {
+    err = cme_error(EINVAL, "`msg` cannot be NULL");
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderVia *via;
+  STAILQ_FOREACH(via, &msg->vias, _next) {
+    cmsc_decode_via_route_addr(via, msg);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_parse_sdp(struct cmsc_SipMessage *msg,
+                           struct cmsc_SdpSession *sdp) {
+  cme_error_t err;
+  if (!msg || !sdp) {
+    err = cme_error(EINVAL, "`msg` and `sdp` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_sdp_parse(msg, sdp);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_parse_multipart(struct cmsc_SipMessage *msg,
+                                 struct cmsc_MultipartBody *multipart) {
+  cme_error_t err;
+  if (!msg || !multipart) {
+    err = cme_error(EINVAL, "`msg` and `multipart` cannot be NULL");
+    goto error_out;
+  }
+
+#if CMSC_WITH_CONTENT_TYPE
+  err = cmsc_multipart_parse(msg, multipart);
+#else
+  err = cme_error(ENOTSUP, "Multipart body requires Content-Type header");
+#endif
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_parse_pidf(struct cmsc_SipMessage *msg,
+                            struct cmsc_PidfPresence *pidf) {
+  cme_error_t err;
+  if (!msg || !pidf) {
+    err = cme_error(EINVAL, "`msg` and `pidf` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_pidf_parse(msg, pidf);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_generate_sip_size(const struct cmsc_SipMessage *msg,
+                                   uint32_t *size) {
+  cme_error_t err;
+  if (!msg || !size) {
+    err = cme_error(EINVAL, "`msg` and `size` cannot be NULL");
+    goto error_out;
+  }
+
+  // Buffer without memory only measures generated message
+  struct cmsc_Writer counter = {.buffer = {.len = 0, .size = 0, .buf = NULL}};
+  err = cmsc_generate_msg(msg, &counter);
+  if (err) {
+    goto error_out;
+  }
+
+  *size = counter.buffer.len;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
 cme_error_t cmsc_generate_sip(const struct cmsc_SipMessage *msg,
                               uint32_t *buf_len, const char **buf) {
   // TO-DO: validate msg content befor generation
@@ -92,50 +235,102 @@ cme_error_t cmsc_generate_sip(const struct cmsc_SipMessage *msg,
     goto error_out;
   }
 
-  struct cmsc_Buffer local_buf = {
-      .len = 0,
-      .size = msg->_buf.len + CMSC_GENERATOR_DEFAULT_SPACE_SIZE,
-      .buf = calloc(msg->_buf.len + CMSC_GENERATOR_DEFAULT_SPACE_SIZE,
-                    sizeof(char))};
-  if (!local_buf.buf) {
+  /* Single pass into buffer which grows if estimate is too small, measuring
+     message first would encode it twice. */
+  uint32_t size = msg->_buf.len + CMSC_GENERATOR_DEFAULT_SPACE_SIZE;
+  struct cmsc_Writer local_buf = {
+      .buffer = {.len = 0, .size = size, .buf = malloc(size)}};
+  if (!local_buf.buffer.buf) {
     err = cme_error(ENOMEM, "Cannot allocate memory for `local_buf`");
     goto error_out;
   }
 
-  err = cmsc_generate_first_line(msg, &local_buf);
+  err = cmsc_generate_msg(msg, &local_buf);
   if (err) {
     goto error_local_buf_cleanup;
   }
 
-  err = cmsc_encode_sip_headers(msg, &local_buf);
+  // One byte more keeps generated message NUL terminated
+  err = cmsc_buffer_reserve(&local_buf.buffer, 1);
   if (err) {
     goto error_local_buf_cleanup;
   }
+  ((char *)local_buf.buffer.buf)[local_buf.buffer.len] = '\0';
 
-  err = cmsc_generate_generic_headers(msg, &local_buf);
-  if (err) {
-    goto error_local_buf_cleanup;
+  *buf = local_buf.buffer.buf;
+  *buf_len = local_buf.buffer.len;
+
+  return 0;
+
+error_local_buf_cleanup:
+  free((void *)local_buf.buffer.buf);
+error_out:
+  return cme_return(err);
+};
+
+cme_error_t cmsc_generate_sip_into(const struct cmsc_SipMessage *msg,
+                                   char *dst, uint32_t cap, uint32_t *len) {
+  cme_error_t err;
+  if (!msg || !dst || !len) {
+    err = cme_error(EINVAL, "`msg`, `dst` and `len` cannot be NULL");
+    goto error_out;
   }
 
-  err = cmsc_buffer_insert(
-      (struct cmsc_String){.buf = "\r\n", .len = strlen("\r\n")}, &local_buf,
-      NULL);
+  // Caller memory is never reallocated, overflow is reported as ENOBUFS
+  struct cmsc_Writer dst_buf = {
+      .buffer = {.len = 0, .size = cap, .buf = dst}, .is_fixed_size = true};
+  err = cmsc_generate_msg(msg, &dst_buf);
+  if (err && err->code == ENOBUFS) {
+    // Message is measured only when it does not fit
+    cme_error_destroy(err);
+    err = cmsc_generate_sip_size(msg, len);
+    if (err) {
+      goto error_out;
+    }
+
+    err = cme_errorf(ENOBUFS, "Generated message needs %u bytes, got %u", *len,
+                     cap);
+    goto error_out;
+  }
   if (err) {
-    goto error_local_buf_cleanup;
+    goto error_out;
+  }
+
+  *len = dst_buf.buffer.len;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_generate_sip_iov(const struct cmsc_SipMessage *msg,
+                                  char *scratch, uint32_t scratch_cap,
+                                  struct iovec *iov, uint32_t iov_cap,
+                                  uint32_t *iov_len) {
+  cme_error_t err;
+  if (!msg || !scratch || !iov || !iov_len) {
+    err = cme_error(EINVAL,
+                    "`msg`, `scratch`, `iov` and `iov_len` cannot be NULL");
+    goto error_out;
   }
 
-  err = cmsc_generate_body(msg, &local_buf);
+  struct cmsc_Writer writer = {
+      .buffer = {.len = 0, .size = scratch_cap, .buf = scratch},
+      .iov = iov,
+      .iov_len = 0,
+      .iov_cap = iov_cap,
+      .source = {.buf = msg->_buf.buf, .len = msg->_buf.len},
+  };
+  err = cmsc_generate_msg(msg, &writer);
   if (err) {
-    goto error_local_buf_cleanup;
+    goto error_out;
   }
 
-  *buf = local_buf.buf;
-  *buf_len = local_buf.len;
+  *iov_len = writer.iov_len;
 
   return 0;
 
-error_local_buf_cleanup:
-  free((void *)local_buf.buf);
 error_out:
   return cme_return(err);
-};
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_ABNF_H
+#define C_MINILIB_SIP_CODEC_ABNF_H
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+#include "utils/bstring.h"
+#include "utils/buffer.h"
+#include "utils/sipmsg.h"
+#include "utils/writer.h"
+
+/* Interpreter for header codecs generated by scripts/gen_codecs.py from
+   scripts/headers.abnf. Generator emits only tables describing header, all
+   decoding and encoding logic lives here. */
+
+enum cmsc_AbnfRules {
+  // According RFC 3261 25.1 token is 1*(alphanum / "-" / "." / "!" / "%" /
+  // "*" / "_" / "+" / "`" / "'" / "~")
+  cmsc_AbnfRules_TOKEN,
+  // 1*DIGIT, stored as uint32_t
+  cmsc_AbnfRules_DELTA_SECONDS,
+  // Whole trimmed value, header cannot have params
+  cmsc_AbnfRules_TEXT,
+};
+
+struct cmsc_AbnfField {
+  // NULL for header value, param name otherwise
+  const char *param;
+  enum cmsc_AbnfRules rule;
+  // Offset of BString or uint32_t inside header struct
+  uint32_t offset;
+};
+
+struct cmsc_AbnfHeader {
+  const char *name;
+  enum cmsc_SupportedSipHeaders id;
+  // Offset and size of header struct inside cmsc_SipMessage
+  uint32_t offset;
+  uint32_t size;
+  // First field is always header value, params follow
+  const struct cmsc_AbnfField *fields;
+  uint32_t fields_len;
+  // Unknown params are kept raw in BString at `params_offset`, if header has
+  // no generic params they are rejected.
+  bool has_generic_params;
+  uint32_t params_offset;
+};
+
+static inline bool cmsc_abnf_is_token(const struct cmsc_String value) {
+  static const char token_chars[] = "-.!%*_+`'~";
+
+  if (!value.len) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < value.len; i++) {
+    if (!isalnum((unsigned char)value.buf[i]) &&
+        !memchr(token_chars, value.buf[i], sizeof(token_chars) - 1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static inline bool cmsc_abnf_decode_field(const struct cmsc_AbnfField *field,
+                                          struct cmsc_String value,
+                                          char *header,
+                                          struct cmsc_SipMessage *msg) {
+  switch (field->rule) {
+  case cmsc_AbnfRules_DELTA_SECONDS:
+    return cmsc_s_to_uint32(value, (uint32_t *)(header + field->offset));
+  case cmsc_AbnfRules_TOKEN:
+    if (!cmsc_abnf_is_token(value)) {
+      return false;
+    }
+    break;
+  case cmsc_AbnfRules_TEXT:
+    if (!value.len) {
+      return false;
+    }
+    break;
+  }
+
+  *(struct cmsc_BString *)(header + field->offset) =
+      cmsc_s_msg_to_bstring(&value, msg);
+  return true;
+}
+
+static inline cme_error_t
+cmsc_abnf_decode(const struct cmsc_AbnfHeader *abnf,
+                 const struct cmsc_SipHeader *sip_header,
+                 struct cmsc_SipMessage *msg) {
+  char *header = (char *)msg + abnf->offset;
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String first = value;
+
+  memset(header, 0, abnf->size);
+
+  if (abnf->fields[0].rule != cmsc_AbnfRules_TEXT) {
+    cmsc_s_next_token(&value, ';', &first);
+  } else {
+    value.len = 0;
+  }
+
+  if (!cmsc_abnf_decode_field(&abnf->fields[0], first, header, msg)) {
+    goto error_malformed;
+  }
+
+  struct cmsc_String param;
+  const char *generic_params = NULL;
+  while (cmsc_s_next_token(&value, ';', &param)) {
+    struct cmsc_String key;
+    struct cmsc_String param_value;
+    cmsc_s_split_param(param, &key, &param_value);
+
+    uint32_t i = 1;
+    for (; i < abnf->fields_len; i++) {
+      if (cmsc_s_equal_nocase(key, abnf->fields[i].param)) {
+        break;
+      }
+    }
+
+    if (i < abnf->fields_len) {
+      if (!cmsc_abnf_decode_field(&abnf->fields[i], param_value, header,
+                                  msg)) {
+        goto error_malformed;
+      }
+    } else if (!abnf->has_generic_params || !key.len) {
+      goto error_malformed;
+    }
+
+    // Raw params span from first to last param, like in other headers
+    if (abnf->has_generic_params) {
+      if (!generic_params) {
+        generic_params = param.buf;
+      }
+      struct cmsc_String params = {.buf = generic_params,
+                                   .len = param.buf + param.len -
+                                          generic_params};
+      *(struct cmsc_BString *)(header + abnf->params_offset) =
+          cmsc_s_msg_to_bstring(&params, msg);
+    }
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, abnf->id);
+  return 0;
+
+error_malformed:
+  return cme_errorf(EINVAL, "Malformed %s sip header: %.*s", abnf->name,
+                    sip_header->value.len,
+                    cmsc_bs_msg_to_string(&sip_header->value, msg).buf);
+}
+
+static inline cme_error_t
+cmsc_abnf_encode_field(const struct cmsc_AbnfField *field,
+                       const char *header, const struct cmsc_SipMessage *msg,
+                       struct cmsc_Writer *writer) {
+  struct cmsc_String param = CMSC_BUFFER_LITERAL("");
+  char digits[CMSC_BUFFER_U32_SIZE];
+  struct cmsc_String value;
+
+  if (field->param) {
+    param = (struct cmsc_String){.buf = field->param,
+                                 .len = (uint32_t)strlen(field->param)};
+  }
+
+  if (field->rule == cmsc_AbnfRules_DELTA_SECONDS) {
+    value = cmsc_buffer_u32_to_string(
+        *(const uint32_t *)(header + field->offset), digits);
+  } else {
+    value = cmsc_bs_msg_to_string(
+        (const struct cmsc_BString *)(header + field->offset),
+        (struct cmsc_SipMessage *)msg);
+  }
+
+  const struct cmsc_String parts[] = {
+      field->param ? CMSC_BUFFER_LITERAL(";") : CMSC_BUFFER_LITERAL(""),
+      param,
+      field->param ? CMSC_BUFFER_LITERAL("=") : CMSC_BUFFER_LITERAL(""),
+      value,
+  };
+
+  return cmsc_writer_insert_parts(
+      parts, sizeof(parts) / sizeof(struct cmsc_String), writer);
+}
+
+/* Params are kept raw when header has generic params, so known params are
+   emitted from raw params too. Otherwise only non empty params are emitted. */
+static inline cme_error_t
+cmsc_abnf_encode(const struct cmsc_AbnfHeader *abnf,
+                 const struct cmsc_SipMessage *msg,
+                 struct cmsc_Writer *writer) {
+  const char *header = (const char *)msg + abnf->offset;
+  cme_error_t err;
+
+  struct cmsc_String name = cmsc_writer_header_name(msg, abnf->id);
+  err = cmsc_writer_insert_parts(&name, 1, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_abnf_encode_field(&abnf->fields[0], header, msg, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  if (abnf->has_generic_params) {
+    const struct cmsc_BString *params =
+        (const struct cmsc_BString *)(header + abnf->params_offset);
+    if (params->len) {
+      const struct cmsc_String raw_params[] = {
+          CMSC_BUFFER_LITERAL(";"),
+          cmsc_bs_msg_to_string(params, (struct cmsc_SipMessage *)msg),
+      };
+      err = cmsc_writer_insert_parts(
+          raw_params, sizeof(raw_params) / sizeof(struct cmsc_String), writer);
+      if (err) {
+        goto error_out;
+      }
+    }
+  } else {
+    for (uint32_t i = 1; i < abnf->fields_len; i++) {
+      const struct cmsc_AbnfField *field = &abnf->fields[i];
+      if (field->rule == cmsc_AbnfRules_DELTA_SECONDS
+              ? !*(const uint32_t *)(header + field->offset)
+              : !((const struct cmsc_BString *)(header + field->offset))
+                     ->len) {
+        continue;
+      }
+
+      err = cmsc_abnf_encode_field(field, header, msg, writer);
+      if (err) {
+        goto error_out;
+      }
+    }
+  }
+
+  err = cmsc_writer_insert_parts(&CMSC_BUFFER_LITERAL("\r\n"), 1, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#endif
@@ -9,8 +9,11 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <strings.h>
 
 #include "c_minilib_error.h"
 #include "c_minilib_sip_codec.h"
@@ -18,6 +21,10 @@
 static inline struct cmsc_BString
 cmsc_s_msg_to_bstring(const struct cmsc_String *src,
                       struct cmsc_SipMessage *msg) {
+  if (!src->buf) {
+    return (struct cmsc_BString){0};
+  }
+
   return (struct cmsc_BString){.buf_offset = src->buf - msg->_buf.buf,
                                .len = src->len};
 }
@@ -43,4 +50,116 @@ static inline void cmsc_bs_trimm(struct cmsc_BString *src, char c_to_sanitize,
   src->len = string.len;
 }
 
+static inline void cmsc_s_trimm_spaces(struct cmsc_String *src) {
+  while (src->len > 0 && isspace(*src->buf)) {
+    src->buf++;
+    src->len--;
+  }
+
+  while (src->len > 0 && isspace(src->buf[src->len - 1])) {
+    src->len--;
+  }
+}
+
+// According RFC 3261 7.3.1 header names are case-insensitive, so is hash.
+static inline uint32_t cmsc_s_hash_nocase(const struct cmsc_String src) {
+  uint32_t hash = 2166136261u;
+  for (uint32_t i = 0; i < src.len; i++) {
+    hash ^= (uint8_t)tolower((unsigned char)src.buf[i]);
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+static inline bool cmsc_s_equal_nocase(const struct cmsc_String src,
+                                       const char *literal) {
+  return src.len == strlen(literal) &&
+         strncasecmp(src.buf, literal, src.len) == 0;
+}
+
+/* Cuts `token` from the front of `src` up to first `delim` which is not
+   inside quotes or angle brackets. Returns false once `src` is exhausted. */
+static inline bool cmsc_s_next_token(struct cmsc_String *src, char delim,
+                                     struct cmsc_String *token) {
+  if (!src->buf || src->len == 0) {
+    return false;
+  }
+
+  bool is_quoted = false;
+  bool is_bracketed = false;
+  uint32_t i = 0;
+  for (; i < src->len; i++) {
+    char c = src->buf[i];
+    if (c == '"' && (i == 0 || src->buf[i - 1] != '\\')) {
+      is_quoted = !is_quoted;
+    } else if (!is_quoted && c == '<') {
+      is_bracketed = true;
+    } else if (!is_quoted && c == '>') {
+      is_bracketed = false;
+    } else if (!is_quoted && !is_bracketed && c == delim) {
+      break;
+    }
+  }
+
+  token->buf = src->buf;
+  token->len = i;
+  cmsc_s_trimm_spaces(token);
+
+  if (i < src->len) {
+    i++;
+  }
+  src->buf += i;
+  src->len -= i;
+
+  return true;
+}
+
+// Returns false if `src` is not a number or does not fit into uint32_t.
+static inline bool cmsc_s_to_uint32(const struct cmsc_String src,
+                                    uint32_t *result) {
+  uint64_t value = 0;
+
+  if (src.len == 0 || src.len > 10) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < src.len; i++) {
+    if (!isdigit(src.buf[i])) {
+      return false;
+    }
+    value = value * 10 + (src.buf[i] - '0');
+  }
+
+  if (value > UINT32_MAX) {
+    return false;
+  }
+
+  *result = (uint32_t)value;
+  return true;
+}
+
+// Splits `key=value` param, quotes around value are removed.
+static inline void cmsc_s_split_param(const struct cmsc_String param,
+                                      struct cmsc_String *key,
+                                      struct cmsc_String *value) {
+  const char *equal = memchr(param.buf, '=', param.len);
+
+  *key = param;
+  *value = (struct cmsc_String){0};
+  if (equal) {
+    key->len = equal - param.buf;
+    value->buf = equal + 1;
+    value->len = param.len - (key->len + 1);
+  }
+
+  cmsc_s_trimm_spaces(key);
+  cmsc_s_trimm_spaces(value);
+  if (value->len >= 2 && value->buf[0] == '"' &&
+      value->buf[value->len - 1] == '"') {
+    value->buf++;
+    value->len -= 2;
+  }
+}
+
 #endif
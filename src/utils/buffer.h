@@ -8,9 +8,7 @@
 #define C_MINILIB_SIP_CODEC_BUFFER_H
 
 #include <errno.h>
-#include <stdarg.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -53,58 +51,110 @@ error_out:
   return cme_return(err);
 };
 
-static inline cme_error_t cmsc_buffer_finsert(struct cmsc_Buffer *buffer,
-                                              struct cmsc_String *result,
-                                              const char *fmt, ...) {
-  if (!buffer || !fmt) {
-    return cme_error(EINVAL, "`buffer` and `fmt` must not be NULL");
+// Largest uint32_t has 10 digits.
+#define CMSC_BUFFER_U32_SIZE 10
+
+#define CMSC_BUFFER_LITERAL(literal)                                           \
+  ((struct cmsc_String){.buf = (literal), .len = sizeof(literal) - 1})
+
+static inline cme_error_t cmsc_buffer_reserve(struct cmsc_Buffer *buffer,
+                                              uint32_t len) {
+  cme_error_t err;
+
+  if (len <= buffer->size - buffer->len) {
+    return 0;
   }
 
-  va_list args;
-  int written;
+  uint32_t new_size = buffer->size ? buffer->size : len;
+  while (len > new_size - buffer->len) {
+    new_size *= 2;
+  }
 
-  // Start with the current buffer length
-  char *dst = (char *)(buffer->buf + buffer->len);
-  uint32_t space = buffer->size - buffer->len;
-  while (true) {
-    va_start(args, fmt);
-    written = vsnprintf(dst, space, fmt, args);
-    va_end(args);
+  char *buf_cp = realloc((void *)buffer->buf, new_size);
+  if (!buf_cp) {
+    err = cme_error(ENOMEM, "Cannot allocate memory for new `buffer->buf`");
+    goto error_out;
+  }
 
-    if (written < 0) {
-      return cme_error(EINVAL, "Formatting failed");
-    }
+  buffer->buf = buf_cp;
+  buffer->size = new_size;
 
-    // Enough space
-    if ((uint32_t)written < space) {
-      break;
-    }
+  return 0;
 
-    // Grow buffer and retry
-    uint32_t new_size = buffer->size;
-    if (written > new_size) {
-      new_size = written;
-    }
+error_out:
+  return cme_return(err);
+}
 
-    new_size *= 2;
-    char *new_buf = realloc((void *)buffer->buf, new_size);
-    if (!new_buf) {
-      return cme_error(ENOMEM, "Cannot realloc buffer");
-    }
+/* Formats `value` into the end of `out`, two digits at a time. Returned string
+   points into `out`. */
+static inline struct cmsc_String
+cmsc_buffer_u32_to_string(uint32_t value, char out[CMSC_BUFFER_U32_SIZE]) {
+  static const char digits[] = "00010203040506070809"
+                               "10111213141516171819"
+                               "20212223242526272829"
+                               "30313233343536373839"
+                               "40414243444546474849"
+                               "50515253545556575859"
+                               "60616263646566676869"
+                               "70717273747576777879"
+                               "80818283848586878889"
+                               "90919293949596979899";
+  char *end = out + CMSC_BUFFER_U32_SIZE;
+  char *digit = end;
+
+  while (value >= 100) {
+    uint32_t pair = (value % 100) * 2;
+    value /= 100;
+    *--digit = digits[pair + 1];
+    *--digit = digits[pair];
+  }
 
-    dst = new_buf + buffer->len;
-    buffer->buf = new_buf;
-    buffer->size = new_size;
-    space = buffer->size - buffer->len;
+  if (value >= 10) {
+    *--digit = digits[value * 2 + 1];
+    *--digit = digits[value * 2];
+  } else {
+    *--digit = (char)('0' + value);
   }
 
-  if (result) {
-    result->buf = buffer->buf + buffer->len;
-    result->len = (uint32_t)written;
+  return (struct cmsc_String){.buf = digit, .len = (uint32_t)(end - digit)};
+}
+
+/* Appends all `parts` with single size check, empty parts are allowed. Buffer
+   without memory only counts bytes, it is used to measure output size. */
+static inline cme_error_t
+cmsc_buffer_insert_parts(const struct cmsc_String *parts, uint32_t parts_len,
+                         struct cmsc_Buffer *buffer) {
+  uint32_t len = 0;
+  cme_error_t err;
+
+  for (uint32_t i = 0; i < parts_len; i++) {
+    len += parts[i].len;
+  }
+
+  if (!buffer->buf) {
+    buffer->len += len;
+    return 0;
   }
 
-  buffer->len += (uint32_t)written;
+  err = cmsc_buffer_reserve(buffer, len);
+  if (err) {
+    goto error_out;
+  }
+
+  char *dst = (char *)buffer->buf + buffer->len;
+  for (uint32_t i = 0; i < parts_len; i++) {
+    if (!parts[i].len) {
+      continue;
+    }
+    memcpy(dst, parts[i].buf, parts[i].len);
+    dst += parts[i].len;
+  }
+  buffer->len += len;
+
   return 0;
+
+error_out:
+  return cme_return(err);
 }
 
 static inline cme_error_t cmsc_buffer_binsert(const struct cmsc_String value,
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+
+#include "utils/bstring.h"
+#include "utils/buffer.h"
+
+#define CMSC_BUILDER_PARTS(builder, ...)                                       \
+  cmsc_builder_write_parts(                                                    \
+      (const struct cmsc_String[]){__VA_ARGS__},                               \
+      sizeof((const struct cmsc_String[]){__VA_ARGS__}) /                      \
+          sizeof(struct cmsc_String),                                          \
+      builder)
+
+// Writes all `parts` or none of them, caller buffer is never grown.
+static cme_error_t cmsc_builder_write_parts(const struct cmsc_String *parts,
+                                            uint32_t parts_len,
+                                            struct cmsc_Builder *builder) {
+  uint32_t len = 0;
+  cme_error_t err;
+
+  for (uint32_t i = 0; i < parts_len; i++) {
+    len += parts[i].len;
+  }
+
+  if (len > builder->_cap - builder->_len) {
+    err = cme_errorf(ENOBUFS, "Builder needs %u bytes more, %u are left", len,
+                     builder->_cap - builder->_len);
+    goto error_out;
+  }
+
+  for (uint32_t i = 0; i < parts_len; i++) {
+    if (!parts[i].len) {
+      continue;
+    }
+    memcpy(builder->_dst + builder->_len, parts[i].buf, parts[i].len);
+    builder->_len += parts[i].len;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmsc_builder_check_begun(struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  if (!builder->_len) {
+    err = cme_error(EINVAL, "Message has to begin with first line");
+    goto error_out;
+  }
+
+  if (builder->_is_finished) {
+    err = cme_error(EINVAL, "Message is already finished");
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmsc_builder_check_headers(struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  err = cmsc_builder_check_begun(builder);
+  if (err) {
+    goto error_out;
+  }
+
+  if (builder->_body_offset) {
+    err = cme_error(EINVAL, "Headers cannot follow body");
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+/* Ends headers with Content-Length and appends first body chunk, both or
+   none of them are written. Content-Length value is reserved as spaces wide
+   enough for any body which fits into the rest of buffer. */
+static cme_error_t cmsc_builder_start_body(const struct cmsc_String body,
+                                           struct cmsc_Builder *builder) {
+  char digits[CMSC_BUFFER_U32_SIZE];
+  cme_error_t err;
+
+  uint32_t width =
+      cmsc_buffer_u32_to_string(builder->_cap - builder->_len, digits).len;
+  static const char spaces[CMSC_BUFFER_U32_SIZE] = "          ";
+
+  err = CMSC_BUILDER_PARTS(
+      builder, CMSC_BUFFER_LITERAL("Content-Length: "),
+      ((struct cmsc_String){.buf = spaces, .len = width}),
+      CMSC_BUFFER_LITERAL("\r\n\r\n"), body);
+  if (err) {
+    goto error_out;
+  }
+
+  builder->_body_offset = builder->_len - body.len;
+  builder->_content_length_offset = builder->_body_offset - 4 - width;
+  builder->_content_length_width = width;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_init(char *dst, uint32_t cap,
+                              struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  if (!dst || !builder) {
+    err = cme_error(EINVAL, "`dst` and `builder` cannot be NULL");
+    goto error_out;
+  }
+
+  *builder = (struct cmsc_Builder){._dst = dst, ._cap = cap};
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_begin_request(uint32_t method_len, const char *method,
+                                       uint32_t req_uri_len,
+                                       const char *req_uri,
+                                       struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  if (!method || !req_uri || !builder) {
+    err = cme_error(EINVAL, "`method`, `req_uri` and `builder` cannot be NULL");
+    goto error_out;
+  }
+
+  if (builder->_len) {
+    err = cme_error(EINVAL, "Message is already begun");
+    goto error_out;
+  }
+
+  err = CMSC_BUILDER_PARTS(
+      builder, ((struct cmsc_String){.buf = method, .len = method_len}),
+      CMSC_BUFFER_LITERAL(" "),
+      ((struct cmsc_String){.buf = req_uri, .len = req_uri_len}),
+      CMSC_BUFFER_LITERAL(" SIP/2.0\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_begin_response(uint32_t status_code,
+                                        uint32_t reason_phrase_len,
+                                        const char *reason_phrase,
+                                        struct cmsc_Builder *builder) {
+  char status_code_buf[CMSC_BUFFER_U32_SIZE];
+  cme_error_t err;
+
+  if (!reason_phrase || !builder) {
+    err = cme_error(EINVAL, "`reason_phrase` and `builder` cannot be NULL");
+    goto error_out;
+  }
+
+  if (status_code < 100 || status_code > 699) {
+    err = cme_errorf(EINVAL, "Invalid status code %u", status_code);
+    goto error_out;
+  }
+
+  if (builder->_len) {
+    err = cme_error(EINVAL, "Message is already begun");
+    goto error_out;
+  }
+
+  err = CMSC_BUILDER_PARTS(
+      builder, CMSC_BUFFER_LITERAL("SIP/2.0 "),
+      cmsc_buffer_u32_to_string(status_code, status_code_buf),
+      CMSC_BUFFER_LITERAL(" "),
+      ((struct cmsc_String){.buf = reason_phrase, .len = reason_phrase_len}),
+      CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_add_via(uint32_t proto_len, const char *proto,
+                                 uint32_t sent_by_len, const char *sent_by,
+                                 uint32_t branch_len, const char *branch,
+                                 struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  if (!proto || !sent_by || !builder) {
+    err = cme_error(EINVAL, "`proto`, `sent_by` and `builder` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_builder_check_headers(builder);
+  if (err) {
+    goto error_out;
+  }
+
+  err = CMSC_BUILDER_PARTS(
+      builder, CMSC_BUFFER_LITERAL("Via: "),
+      ((struct cmsc_String){.buf = proto, .len = proto_len}),
+      CMSC_BUFFER_LITERAL(" "),
+      ((struct cmsc_String){.buf = sent_by, .len = sent_by_len}),
+      branch && branch_len ? CMSC_BUFFER_LITERAL(";branch=")
+                           : CMSC_BUFFER_LITERAL(""),
+      ((struct cmsc_String){.buf = branch, .len = branch ? branch_len : 0}),
+      CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_add_header(uint32_t name_len, const char *name,
+                                    uint32_t value_len, const char *value,
+                                    struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  if (!name || !value || !builder) {
+    err = cme_error(EINVAL, "`name`, `value` and `builder` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_builder_check_headers(builder);
+  if (err) {
+    goto error_out;
+  }
+
+  // Content-Length is written by builder itself, second one would conflict
+  struct cmsc_String header_name = {.buf = name, .len = name_len};
+  if (cmsc_s_equal_nocase(header_name, "Content-Length") ||
+      cmsc_s_equal_nocase(header_name, "l")) {
+    err = cme_error(EINVAL, "Content-Length is set by builder");
+    goto error_out;
+  }
+
+  err = CMSC_BUILDER_PARTS(
+      builder, header_name,
+      CMSC_BUFFER_LITERAL(": "),
+      ((struct cmsc_String){.buf = value, .len = value_len}),
+      CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_set_body(uint32_t body_len, const char *body,
+                                  struct cmsc_Builder *builder) {
+  cme_error_t err;
+
+  if (!body || !builder) {
+    err = cme_error(EINVAL, "`body` and `builder` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_builder_check_begun(builder);
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_String chunk = {.buf = body, .len = body_len};
+  if (!builder->_body_offset) {
+    err = cmsc_builder_start_body(chunk, builder);
+  } else {
+    err = CMSC_BUILDER_PARTS(builder, chunk);
+  }
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_builder_finish(struct cmsc_Builder *builder, uint32_t *len) {
+  char digits[CMSC_BUFFER_U32_SIZE];
+  cme_error_t err;
+
+  if (!builder || !len) {
+    err = cme_error(EINVAL, "`builder` and `len` cannot be NULL");
+    goto error_out;
+  }
+
+  if (builder->_is_finished) {
+    *len = builder->_len;
+    return 0;
+  }
+
+  err = cmsc_builder_check_begun(builder);
+  if (err) {
+    goto error_out;
+  }
+
+  if (!builder->_body_offset) {
+    err = CMSC_BUILDER_PARTS(builder,
+                             CMSC_BUFFER_LITERAL("Content-Length: 0\r\n\r\n"));
+    if (err) {
+      goto error_out;
+    }
+  } else {
+    // Reserved width fits any body, so value is only right aligned
+    struct cmsc_String content_length = cmsc_buffer_u32_to_string(
+        builder->_len - builder->_body_offset, digits);
+    memcpy(builder->_dst + builder->_content_length_offset +
+               builder->_content_length_width - content_length.len,
+           content_length.buf, content_length.len);
+  }
+
+  builder->_is_finished = true;
+  *len = builder->_len;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
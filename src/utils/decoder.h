@@ -7,67 +7,78 @@
 #ifndef C_MINILIB_SIP_CODEC_DECODER_H
 #define C_MINILIB_SIP_CODEC_DECODER_H
 
+#include <arpa/inet.h>
 #include <asm-generic/errno-base.h>
 #include <ctype.h>
 #include <errno.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <netinet/in.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/queue.h>
+#include <sys/socket.h>
 
 #include "c_minilib_error.h"
 #include "c_minilib_sip_codec.h"
 #include "utils/bstring.h"
+#include "utils/generated_codecs.h"
+#include "utils/registry.h"
 #include "utils/sipmsg.h"
+#include "utils/siptokens.h"
 #include "utils/tag_iterator.h"
 
-struct cmsc_DecoderLogic {
-  struct cmsc_String header_id;
-  cme_error_t (*decode_func)(const struct cmsc_SipHeader *sip_header,
-                             struct cmsc_SipMessage *msg);
-};
+#define CMSC_X(id, suffix, ...)                                                \
+  static inline cme_error_t cmsc_decode_func_##suffix(                         \
+      const struct cmsc_SipHeader *sip_header, struct cmsc_SipMessage *msg);
+CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
+
+// Decoders of headers supported out of the box, used to build registry.
+static inline const struct cmsc_DecoderLogic *
+cmsc_decoders_builtin(uint32_t *len) {
+  // Headers without compact form produce empty entry, registry skips them.
+  static const struct cmsc_DecoderLogic decoders[] = {
+#define CMSC_X(hid, suffix, hfield, type, name, compact_name, ...)             \
+  {.header_id = {.buf = name, .len = sizeof(name) - 1},                        \
+   .decode_func = cmsc_decode_func_##suffix,                                   \
+   .field = cmsc_SupportedSipHeaders_##hid},                                   \
+  {.header_id = {.buf = compact_name, .len = sizeof(compact_name) - 1},        \
+   .decode_func = cmsc_decode_func_##suffix,                                   \
+   .field = cmsc_SupportedSipHeaders_##hid},
+      CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
+  };
+
+  *len = sizeof(decoders) / sizeof(struct cmsc_DecoderLogic);
+  return decoders;
+}
 
 static inline cme_error_t
-cmsc_decode_func_to(const struct cmsc_SipHeader *sip_header,
-                    struct cmsc_SipMessage *msg);
-static inline cme_error_t
-cmsc_decode_func_via(const struct cmsc_SipHeader *sip_header,
-                     struct cmsc_SipMessage *msg);
-static inline cme_error_t
-cmsc_decode_func_from(const struct cmsc_SipHeader *sip_header,
-                      struct cmsc_SipMessage *msg);
-static inline cme_error_t
-cmsc_decode_func_cseq(const struct cmsc_SipHeader *sip_header,
-                      struct cmsc_SipMessage *msg);
-static inline cme_error_t
-cmsc_decode_func_call_id(const struct cmsc_SipHeader *sip_header,
-                         struct cmsc_SipMessage *msg);
-static inline cme_error_t
-cmsc_decode_func_max_forwards(const struct cmsc_SipHeader *sip_header,
-                              struct cmsc_SipMessage *msg);
-static inline cme_error_t
-cmsc_decode_func_content_length(const struct cmsc_SipHeader *sip_header,
-                                struct cmsc_SipMessage *msg);
+cmsc_decode_extension(const struct cmsc_SipHeader *sip_header,
+                      const struct cmsc_HeaderCodec *codec,
+                      struct cmsc_SipMessage *msg) {
+  struct cmsc_SipHeaderExtension *extension = &msg->extensions[codec->slot];
+  cme_error_t err;
+
+  extension->value = sip_header->value;
+
+  if (codec->decode_func) {
+    err = codec->decode_func(sip_header, msg, extension);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  msg->extensions_mask |= 1u << codec->slot;
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
 
 static inline cme_error_t cmsc_decode_sip_headers(struct cmsc_SipMessage *msg) {
-  static struct cmsc_DecoderLogic decoders[] = {
-      {.header_id = {.buf = "To", .len = sizeof("To") - 1},
-       .decode_func = cmsc_decode_func_to},
-      {.header_id = {.buf = "Via", .len = sizeof("Via") - 1},
-       .decode_func = cmsc_decode_func_via},
-      {.header_id = {.buf = "From", .len = sizeof("From") - 1},
-       .decode_func = cmsc_decode_func_from},
-      {.header_id = {.buf = "CSeq", .len = sizeof("CSeq") - 1},
-       .decode_func = cmsc_decode_func_cseq},
-      {.header_id = {.buf = "Call-ID", .len = sizeof("Call-ID") - 1},
-       .decode_func = cmsc_decode_func_call_id},
-      {.header_id = {.buf = "Max-Forwards", .len = sizeof("Max-Forwards") - 1},
-       .decode_func = cmsc_decode_func_max_forwards},
-      {.header_id = {.buf = "Content-Length",
-                     .len = sizeof("Content-Length") - 1},
-       .decode_func = cmsc_decode_func_content_length},
-  };
   cme_error_t err;
 
   if (!msg) {
@@ -82,26 +93,26 @@ static inline cme_error_t cmsc_decode_sip_headers(struct cmsc_SipMessage *msg) {
   while (generic_header != NULL) {
     next_header = STAILQ_NEXT(generic_header, _next);
 
+    const struct cmsc_DecoderLogic *decoder =
+        cmsc_registry_get_decoder(generic_header->id);
+
+    // Value ends right before CRLF until it is trimmed
+    cmsc_sipmsg_record_line(generic_header->key.buf_offset,
+                            generic_header->value.buf_offset +
+                                generic_header->value.len + 2,
+                            decoder ? decoder->field : 0, msg);
+
     cmsc_bs_trimm(&generic_header->value, ' ', msg);
 
     // Parse generic header
-    bool is_match = false;
-    for (uint32_t i = 0;
-         i < sizeof(decoders) / sizeof(struct cmsc_DecoderLogic); i++) {
-      if (strncmp(decoders[i].header_id.buf,
-                  cmsc_bs_msg_to_string(&generic_header->key, msg).buf,
-                  generic_header->key.len) == 0) {
-        is_match = true;
-        err = decoders[i].decode_func(generic_header, msg);
-        if (err) {
-          goto error_out;
-        }
-
-        break;
+    if (decoder) {
+      err = decoder->codec
+                ? cmsc_decode_extension(generic_header, decoder->codec, msg)
+                : decoder->decode_func(generic_header, msg);
+      if (err) {
+        goto error_out;
       }
-    }
 
-    if (is_match) {
       STAILQ_REMOVE(&msg->sip_headers, generic_header, cmsc_SipHeader, _next);
       free(generic_header);
     }
@@ -235,15 +246,23 @@ cmsc_decode_func_max_forwards(const struct cmsc_SipHeader *sip_header,
   return 0;
 };
 
-static inline cme_error_t
-cmsc_decode_func_via(const struct cmsc_SipHeader *sip_header,
-                     struct cmsc_SipMessage *msg) {
+static inline uint32_t cmsc_decode_port(struct cmsc_String port) {
+  uint32_t result = 0;
+
+  if (!cmsc_s_to_uint32(port, &result) || result > UINT16_MAX) {
+    return 0;
+  }
+
+  return result;
+}
+
+static inline cme_error_t cmsc_decode_via(struct cmsc_String entry,
+                                          struct cmsc_SipMessage *msg) {
   struct cmsc_SipHeaderVia *via = NULL;
   struct cmsc_ArgIterator iter;
   cme_error_t err;
 
-  err = cmsc_arg_iterator_init(cmsc_bs_msg_to_string(&sip_header->value, msg),
-                               &iter);
+  err = cmsc_arg_iterator_init(entry, &iter);
   if (err) {
     goto error_out;
   }
@@ -283,12 +302,12 @@ cmsc_decode_func_via(const struct cmsc_SipHeader *sip_header,
 
       if (!via->proto.buf_offset || !via->sent_by.buf_offset) {
         free(via);
-        err = cme_errorf(EINVAL, "Malformed Via sip header: %.*s",
-                         sip_header->value.len,
-                         cmsc_bs_msg_to_string(&sip_header->value, msg).buf);
+        err = cme_errorf(EINVAL, "Malformed Via sip header: %.*s", entry.len,
+                         entry.buf);
         goto error_out;
       }
 
+      via->raw = cmsc_s_msg_to_bstring(&entry, msg);
       STAILQ_INSERT_TAIL(&msg->vias, via, _next);
       cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_VIAS);
       break;
@@ -306,6 +325,15 @@ cmsc_decode_func_via(const struct cmsc_SipHeader *sip_header,
         via->received = cmsc_s_msg_to_bstring(&iter.arg_value, msg);
       } else if (strncmp("ttl", iter.arg_key.buf, iter.arg_key.len) == 0) {
         via->ttl = atoi(iter.arg_value.buf);
+      } else if (strncmp("rport", iter.arg_key.buf, iter.arg_key.len) == 0) {
+        // Requests carry `rport` without value, RFC 3581 3
+        via->has_rport = true;
+        if (iter.arg_value.len &&
+            !(via->rport = cmsc_decode_port(iter.arg_value))) {
+          err = cme_errorf(EINVAL, "Invalid Via rport: %.*s",
+                           iter.arg_value.len, iter.arg_value.buf);
+          goto error_out;
+        }
       }
 
       break;
@@ -320,6 +348,35 @@ error_out:
   return cme_return(err);
 };
 
+static inline cme_error_t
+cmsc_decode_func_via(const struct cmsc_SipHeader *sip_header,
+                     struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 3261 25 via looks like this:
+      Via =  ( "Via" / "v" ) HCOLON via-parm *(COMMA via-parm)
+  */
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String entry;
+  cme_error_t err;
+
+  while (cmsc_s_next_token(&value, ',', &entry)) {
+    cmsc_s_trimm_spaces(&entry);
+    if (!entry.len) {
+      continue;
+    }
+
+    err = cmsc_decode_via(entry, msg);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
 static inline cme_error_t
 cmsc_decode_func_content_length(const struct cmsc_SipHeader *sip_header,
                                 struct cmsc_SipMessage *msg) {
@@ -329,4 +386,785 @@ cmsc_decode_func_content_length(const struct cmsc_SipHeader *sip_header,
   return 0;
 }
 
+static inline cme_error_t
+cmsc_decode_tokens(const struct cmsc_SipHeader *sip_header,
+                   const struct cmsc_TokensTable *table,
+                   struct cmsc_SipHeaderTokens *tokens,
+                   struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 3261 25 tokens lists look like this:
+      Allow      =  "Allow" HCOLON [Method *(COMMA Method)]
+      Supported  =  ( "Supported" / "k" ) HCOLON
+                    [option-tag *(COMMA option-tag)]
+  */
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  const char *max_char = value.buf + value.len;
+  const char *current_char = value.buf;
+  cme_error_t err;
+
+  while (current_char != max_char) {
+    while (current_char != max_char &&
+           (*current_char == ',' || isspace(*current_char))) {
+      current_char++;
+    }
+
+    struct cmsc_String token = {.buf = current_char, .len = 0};
+    while (current_char != max_char && *current_char != ',' &&
+           !isspace(*current_char)) {
+      current_char++;
+      token.len++;
+    }
+
+    if (token.len == 0) {
+      continue;
+    }
+
+    uint32_t id = cmsc_siptokens_lookup(table, token);
+    if (id) {
+      tokens->mask |= id;
+      continue;
+    }
+
+    struct cmsc_SipToken *unknown = calloc(1, sizeof(struct cmsc_SipToken));
+    if (!unknown) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `unknown`");
+      goto error_out;
+    }
+
+    unknown->token = cmsc_s_msg_to_bstring(&token, msg);
+    STAILQ_INSERT_TAIL(&tokens->unknown, unknown, _next);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_ALLOW
+static inline cme_error_t
+cmsc_decode_func_allow(const struct cmsc_SipHeader *sip_header,
+                       struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_tokens(sip_header, cmsc_siptokens_methods(),
+                                       &msg->allow, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_ALLOW);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_SUPPORTED
+static inline cme_error_t
+cmsc_decode_func_supported(const struct cmsc_SipHeader *sip_header,
+                           struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_tokens(
+      sip_header, cmsc_siptokens_option_tags(), &msg->supported, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_SUPPORTED);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_REQUIRE
+static inline cme_error_t
+cmsc_decode_func_require(const struct cmsc_SipHeader *sip_header,
+                         struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_tokens(
+      sip_header, cmsc_siptokens_option_tags(), &msg->require, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_REQUIRE);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_PROXY_REQUIRE
+static inline cme_error_t
+cmsc_decode_func_proxy_require(const struct cmsc_SipHeader *sip_header,
+                               struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_tokens(
+      sip_header, cmsc_siptokens_option_tags(), &msg->proxy_require, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_PROXY_REQUIRE);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_UNSUPPORTED
+static inline cme_error_t
+cmsc_decode_func_unsupported(const struct cmsc_SipHeader *sip_header,
+                             struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_tokens(
+      sip_header, cmsc_siptokens_option_tags(), &msg->unsupported, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_UNSUPPORTED);
+  return 0;
+}
+#endif
+
+static inline void
+cmsc_decode_content_type(struct cmsc_SipHeaderContentType *content_type,
+                         struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 3261 25 content type looks like this:
+      Content-Type     =  ( "Content-Type" / "c" ) HCOLON media-type
+      media-type       =  m-type SLASH m-subtype *(SEMI m-parameter)
+    It expects `type` and `params` to be already set.
+  */
+  struct cmsc_String type = cmsc_bs_msg_to_string(&content_type->type, msg);
+  cmsc_s_trimm_spaces(&type);
+  content_type->type = cmsc_s_msg_to_bstring(&type, msg);
+
+  content_type->media_type = cmsc_siptokens_lookup(
+      cmsc_siptokens_media_types(), type);
+  if (content_type->media_type == cmsc_MediaTypes_NONE) {
+    content_type->media_type = cmsc_MediaTypes_UNKNOWN;
+  }
+
+  struct cmsc_String params =
+      cmsc_bs_msg_to_string(&content_type->params, msg);
+  struct cmsc_String param;
+  while (cmsc_s_next_token(&params, ';', &param)) {
+    struct cmsc_String key;
+    struct cmsc_String value;
+    cmsc_s_split_param(param, &key, &value);
+
+    if (cmsc_s_equal_nocase(key, "boundary")) {
+      content_type->boundary = cmsc_s_msg_to_bstring(&value, msg);
+    } else if (cmsc_s_equal_nocase(key, "charset")) {
+      content_type->charset = cmsc_s_msg_to_bstring(&value, msg);
+    }
+  }
+}
+
+static inline void cmsc_decode_event(struct cmsc_SipHeaderEvent *event,
+                                     struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 6665 8.4 event looks like this:
+      Event       =  ( "Event" / "o" ) HCOLON event-type
+                     *( SEMI event-param )
+      event-param =  generic-param / ( "id" EQUAL token )
+    It expects `package` and `params` to be already set.
+  */
+  struct cmsc_String params = cmsc_bs_msg_to_string(&event->params, msg);
+  struct cmsc_String param;
+
+  event->id = (struct cmsc_BString){0};
+  while (cmsc_s_next_token(&params, ';', &param)) {
+    struct cmsc_String key;
+    struct cmsc_String value;
+    cmsc_s_split_param(param, &key, &value);
+
+    if (cmsc_s_equal_nocase(key, "id")) {
+      event->id = cmsc_s_msg_to_bstring(&value, msg);
+    }
+  }
+}
+
+static inline void cmsc_decode_subscription_state(
+    struct cmsc_SipHeaderSubscriptionState *subscription_state,
+    struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 6665 8.4 subscription state looks like this:
+      Subscription-State   = "Subscription-State" HCOLON substate-value
+                             *( SEMI subexp-params )
+      subexp-params        =   ("reason" EQUAL event-reason-value)
+                             / ("expires" EQUAL delta-seconds)
+                             / ("retry-after" EQUAL delta-seconds)
+                             / generic-param
+    It expects `state_name` and `params` to be already set.
+  */
+  struct cmsc_String state_name =
+      cmsc_bs_msg_to_string(&subscription_state->state_name, msg);
+  subscription_state->state = cmsc_siptokens_lookup(
+      cmsc_siptokens_subscription_states(), state_name);
+  if (subscription_state->state == cmsc_SubscriptionStates_NONE) {
+    subscription_state->state = cmsc_SubscriptionStates_UNKNOWN;
+  }
+
+  struct cmsc_String params =
+      cmsc_bs_msg_to_string(&subscription_state->params, msg);
+  struct cmsc_String param;
+  while (cmsc_s_next_token(&params, ';', &param)) {
+    struct cmsc_String key;
+    struct cmsc_String value;
+    cmsc_s_split_param(param, &key, &value);
+
+    if (cmsc_s_equal_nocase(key, "reason")) {
+      subscription_state->reason = cmsc_s_msg_to_bstring(&value, msg);
+    } else if (cmsc_s_equal_nocase(key, "expires")) {
+      cmsc_s_to_uint32(value, &subscription_state->expires);
+    } else if (cmsc_s_equal_nocase(key, "retry-after")) {
+      cmsc_s_to_uint32(value, &subscription_state->retry_after);
+    }
+  }
+}
+
+/* Splits `value; params` header into value and raw params, value cannot be
+   empty. */
+static inline cme_error_t
+cmsc_decode_value_with_params(const struct cmsc_SipHeader *sip_header,
+                              struct cmsc_BString *value,
+                              struct cmsc_BString *params,
+                              struct cmsc_SipMessage *msg) {
+  struct cmsc_String header_value =
+      cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String first = {0};
+
+  cmsc_s_next_token(&header_value, ';', &first);
+  if (!first.len) {
+    return cme_errorf(EINVAL, "Malformed %.*s sip header: %.*s",
+                      sip_header->key.len,
+                      cmsc_bs_msg_to_string(&sip_header->key, msg).buf,
+                      sip_header->value.len,
+                      cmsc_bs_msg_to_string(&sip_header->value, msg).buf);
+  }
+
+  *value = cmsc_s_msg_to_bstring(&first, msg);
+  *params = (struct cmsc_BString){0};
+
+  cmsc_s_trimm_spaces(&header_value);
+  if (header_value.len) {
+    *params = cmsc_s_msg_to_bstring(&header_value, msg);
+  }
+
+  return 0;
+}
+
+#if CMSC_WITH_CONTENT_TYPE
+static inline cme_error_t
+cmsc_decode_func_content_type(const struct cmsc_SipHeader *sip_header,
+                              struct cmsc_SipMessage *msg) {
+  memset(&msg->content_type, 0, sizeof(struct cmsc_SipHeaderContentType));
+
+  cme_error_t err = cmsc_decode_value_with_params(
+      sip_header, &msg->content_type.type, &msg->content_type.params, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  if (!memchr(cmsc_bs_msg_to_string(&msg->content_type.type, msg).buf, '/',
+              msg->content_type.type.len)) {
+    return cme_errorf(EINVAL, "Malformed Content-Type sip header: %.*s",
+                      sip_header->value.len,
+                      cmsc_bs_msg_to_string(&sip_header->value, msg).buf);
+  }
+
+  cmsc_decode_content_type(&msg->content_type, msg);
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_CONTENT_TYPE);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_EVENT
+static inline cme_error_t
+cmsc_decode_func_event(const struct cmsc_SipHeader *sip_header,
+                       struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_value_with_params(
+      sip_header, &msg->event.package, &msg->event.params, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_decode_event(&msg->event, msg);
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_EVENT);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_SUBSCRIPTION_STATE
+static inline cme_error_t
+cmsc_decode_func_subscription_state(const struct cmsc_SipHeader *sip_header,
+                                    struct cmsc_SipMessage *msg) {
+  memset(&msg->subscription_state, 0,
+         sizeof(struct cmsc_SipHeaderSubscriptionState));
+
+  cme_error_t err = cmsc_decode_value_with_params(
+      sip_header, &msg->subscription_state.state_name,
+      &msg->subscription_state.params, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_decode_subscription_state(&msg->subscription_state, msg);
+  cmsc_sipmsg_mark_field_present(msg,
+                                 cmsc_SupportedSipHeaders_SUBSCRIPTION_STATE);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_EXPIRES
+static inline cme_error_t
+cmsc_decode_func_expires(const struct cmsc_SipHeader *sip_header,
+                         struct cmsc_SipMessage *msg) {
+  if (!cmsc_s_to_uint32(cmsc_bs_msg_to_string(&sip_header->value, msg),
+                        &msg->expires)) {
+    return cme_errorf(EINVAL, "Malformed Expires sip header: %.*s",
+                      sip_header->value.len,
+                      cmsc_bs_msg_to_string(&sip_header->value, msg).buf);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_EXPIRES);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_MIN_EXPIRES
+static inline cme_error_t
+cmsc_decode_func_min_expires(const struct cmsc_SipHeader *sip_header,
+                             struct cmsc_SipMessage *msg) {
+  if (!cmsc_s_to_uint32(cmsc_bs_msg_to_string(&sip_header->value, msg),
+                        &msg->min_expires)) {
+    return cme_errorf(EINVAL, "Malformed Min-Expires sip header: %.*s",
+                      sip_header->value.len,
+                      cmsc_bs_msg_to_string(&sip_header->value, msg).buf);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_MIN_EXPIRES);
+  return 0;
+}
+#endif
+
+static inline cme_error_t
+cmsc_decode_name_addr(struct cmsc_String entry,
+                      struct cmsc_String *display_name,
+                      struct cmsc_String *uri, struct cmsc_String *params) {
+  /*
+    According RFC 3261 25 name-addr looks like this:
+      name-addr      =  [ display-name ] LAQUOT addr-spec RAQUOT
+      display-name   =  *(token LWS)/ quoted-string
+    If addr-spec is used without brackets, params following `;` are not part
+    of the uri.
+  */
+  struct cmsc_String rest = entry;
+  struct cmsc_String uri_part = {0};
+
+  *display_name = (struct cmsc_String){0};
+  *params = (struct cmsc_String){0};
+
+  cmsc_s_next_token(&rest, ';', &uri_part);
+
+  const char *laquot = memchr(uri_part.buf, '<', uri_part.len);
+  if (laquot) {
+    const char *raquot =
+        memchr(laquot, '>', uri_part.len - (laquot - uri_part.buf));
+    if (!raquot) {
+      goto error_out;
+    }
+
+    display_name->buf = uri_part.buf;
+    display_name->len = laquot - uri_part.buf;
+    cmsc_s_trimm_spaces(display_name);
+    if (display_name->len >= 2 && display_name->buf[0] == '"' &&
+        display_name->buf[display_name->len - 1] == '"') {
+      display_name->buf++;
+      display_name->len -= 2;
+    }
+
+    uri->buf = laquot + 1;
+    uri->len = raquot - uri->buf;
+  } else {
+    *uri = uri_part;
+  }
+
+  cmsc_s_trimm_spaces(uri);
+  if (!uri->len) {
+    goto error_out;
+  }
+
+  cmsc_s_trimm_spaces(&rest);
+  *params = rest;
+
+  return 0;
+
+error_out:
+  return cme_errorf(EINVAL, "Malformed name-addr: %.*s", entry.len, entry.buf);
+}
+
+static inline cme_error_t
+cmsc_decode_identities(const struct cmsc_SipHeader *sip_header,
+                       struct cmsc_SipIdentitiesList *identities,
+                       struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 3325 9.1 identities look like this:
+      PAssertedID = "P-Asserted-Identity" HCOLON PAssertedID-value
+                    *(COMMA PAssertedID-value)
+      PAssertedID-value = name-addr / addr-spec
+  */
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String entry;
+  cme_error_t err;
+
+  while (cmsc_s_next_token(&value, ',', &entry)) {
+    if (!entry.len) {
+      continue;
+    }
+
+    struct cmsc_String display_name;
+    struct cmsc_String uri;
+    struct cmsc_String params;
+    err = cmsc_decode_name_addr(entry, &display_name, &uri, &params);
+    if (err) {
+      goto error_out;
+    }
+
+    struct cmsc_SipHeaderIdentity *identity =
+        calloc(1, sizeof(struct cmsc_SipHeaderIdentity));
+    if (!identity) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `identity`");
+      goto error_out;
+    }
+
+    identity->display_name = cmsc_s_msg_to_bstring(&display_name, msg);
+    identity->uri = cmsc_s_msg_to_bstring(&uri, msg);
+    identity->params = cmsc_s_msg_to_bstring(&params, msg);
+    identity->is_name_addr = memchr(entry.buf, '<', uri.buf - entry.buf);
+    STAILQ_INSERT_TAIL(identities, identity, _next);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_P_ASSERTED_IDENTITY
+static inline cme_error_t
+cmsc_decode_func_p_asserted_identity(const struct cmsc_SipHeader *sip_header,
+                                     struct cmsc_SipMessage *msg) {
+  cme_error_t err =
+      cmsc_decode_identities(sip_header, &msg->p_asserted_identities, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg,
+                                 cmsc_SupportedSipHeaders_P_ASSERTED_IDENTITY);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_P_PREFERRED_IDENTITY
+static inline cme_error_t
+cmsc_decode_func_p_preferred_identity(const struct cmsc_SipHeader *sip_header,
+                                      struct cmsc_SipMessage *msg) {
+  cme_error_t err =
+      cmsc_decode_identities(sip_header, &msg->p_preferred_identities, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg,
+                                 cmsc_SupportedSipHeaders_P_PREFERRED_IDENTITY);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_ROUTE || CMSC_WITH_RECORD_ROUTE
+static inline cme_error_t
+cmsc_decode_routes(const struct cmsc_SipHeader *sip_header,
+                   struct cmsc_SipRoutesList *routes,
+                   struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 3261 25 routes look like this:
+      Route        =  "Route" HCOLON route-param *(COMMA route-param)
+      Record-Route =  "Record-Route" HCOLON rec-route *(COMMA rec-route)
+      route-param  =  name-addr *( SEMI rr-param )
+  */
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String entry;
+  cme_error_t err;
+
+  while (cmsc_s_next_token(&value, ',', &entry)) {
+    if (!entry.len) {
+      continue;
+    }
+
+    struct cmsc_String display_name;
+    struct cmsc_String uri;
+    struct cmsc_String params;
+    err = cmsc_decode_name_addr(entry, &display_name, &uri, &params);
+    if (err) {
+      goto error_out;
+    }
+
+    struct cmsc_SipHeaderRoute *route =
+        calloc(1, sizeof(struct cmsc_SipHeaderRoute));
+    if (!route) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `route`");
+      goto error_out;
+    }
+
+    route->display_name = cmsc_s_msg_to_bstring(&display_name, msg);
+    route->uri = cmsc_s_msg_to_bstring(&uri, msg);
+    route->params = cmsc_s_msg_to_bstring(&params, msg);
+    STAILQ_INSERT_TAIL(routes, route, _next);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_ROUTE
+static inline cme_error_t
+cmsc_decode_func_route(const struct cmsc_SipHeader *sip_header,
+                       struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_routes(sip_header, &msg->routes, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_ROUTE);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_RECORD_ROUTE
+static inline cme_error_t
+cmsc_decode_func_record_route(const struct cmsc_SipHeader *sip_header,
+                              struct cmsc_SipMessage *msg) {
+  cme_error_t err = cmsc_decode_routes(sip_header, &msg->record_routes, msg);
+  if (err) {
+    return cme_return(err);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_RECORD_ROUTE);
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_DIVERSION
+static inline cme_error_t
+cmsc_decode_func_diversion(const struct cmsc_SipHeader *sip_header,
+                           struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 5806 A diversion looks like this:
+      Diversion        = "Diversion" ":" 1# (name-addr
+                         *( ";" diversion_params ))
+      diversion-params = diversion-reason / diversion-counter /
+                         diversion-limit / diversion-privacy /
+                         diversion-screen / diversion-extension
+  */
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String entry;
+  cme_error_t err;
+
+  while (cmsc_s_next_token(&value, ',', &entry)) {
+    if (!entry.len) {
+      continue;
+    }
+
+    struct cmsc_String display_name;
+    struct cmsc_String uri;
+    struct cmsc_String params;
+    err = cmsc_decode_name_addr(entry, &display_name, &uri, &params);
+    if (err) {
+      goto error_out;
+    }
+
+    struct cmsc_SipHeaderDiversion *diversion =
+        calloc(1, sizeof(struct cmsc_SipHeaderDiversion));
+    if (!diversion) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `diversion`");
+      goto error_out;
+    }
+
+    diversion->display_name = cmsc_s_msg_to_bstring(&display_name, msg);
+    diversion->uri = cmsc_s_msg_to_bstring(&uri, msg);
+    diversion->params = cmsc_s_msg_to_bstring(&params, msg);
+    diversion->counter = 1;
+
+    struct cmsc_String param;
+    while (cmsc_s_next_token(&params, ';', &param)) {
+      struct cmsc_String key;
+      struct cmsc_String param_value;
+      cmsc_s_split_param(param, &key, &param_value);
+
+      if (cmsc_s_equal_nocase(key, "reason")) {
+        diversion->reason = cmsc_s_msg_to_bstring(&param_value, msg);
+      } else if (cmsc_s_equal_nocase(key, "counter")) {
+        cmsc_s_to_uint32(param_value, &diversion->counter);
+      }
+    }
+
+    STAILQ_INSERT_TAIL(&msg->diversions, diversion, _next);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_DIVERSION);
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_HISTORY_INFO
+static inline cme_error_t
+cmsc_decode_func_history_info(const struct cmsc_SipHeader *sip_header,
+                              struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 7044 9 history info looks like this:
+      History-Info = "History-Info" HCOLON hi-entry *(COMMA hi-entry)
+      hi-entry = hi-targeted-to-uri *(SEMI hi-param)
+      hi-param = hi-index / hi-target-param / hi-extension
+      hi-index = "index" EQUAL hi-index-val
+  */
+  struct cmsc_String value = cmsc_bs_msg_to_string(&sip_header->value, msg);
+  struct cmsc_String entry;
+  cme_error_t err;
+
+  while (cmsc_s_next_token(&value, ',', &entry)) {
+    if (!entry.len) {
+      continue;
+    }
+
+    struct cmsc_String display_name;
+    struct cmsc_String uri;
+    struct cmsc_String params;
+    err = cmsc_decode_name_addr(entry, &display_name, &uri, &params);
+    if (err) {
+      goto error_out;
+    }
+
+    struct cmsc_SipHeaderHistoryInfo *history_info =
+        calloc(1, sizeof(struct cmsc_SipHeaderHistoryInfo));
+    if (!history_info) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `history_info`");
+      goto error_out;
+    }
+
+    history_info->display_name = cmsc_s_msg_to_bstring(&display_name, msg);
+    history_info->uri = cmsc_s_msg_to_bstring(&uri, msg);
+    history_info->params = cmsc_s_msg_to_bstring(&params, msg);
+
+    struct cmsc_String param;
+    while (cmsc_s_next_token(&params, ';', &param)) {
+      struct cmsc_String key;
+      struct cmsc_String param_value;
+      cmsc_s_split_param(param, &key, &param_value);
+
+      if (cmsc_s_equal_nocase(key, "index")) {
+        history_info->index = cmsc_s_msg_to_bstring(&param_value, msg);
+      }
+    }
+
+    STAILQ_INSERT_TAIL(&msg->history_infos, history_info, _next);
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_HISTORY_INFO);
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+static inline bool cmsc_decode_ip_addr(struct cmsc_String host, uint32_t port,
+                                       struct sockaddr_storage *addr) {
+  char host_cp[INET6_ADDRSTRLEN + 1];
+
+  cmsc_s_trimm(&host, '[');
+  cmsc_s_trimm(&host, ']');
+  if (host.len == 0 || host.len > INET6_ADDRSTRLEN) {
+    return false;
+  }
+
+  // inet_pton requires null terminated string
+  memcpy(host_cp, host.buf, host.len);
+  host_cp[host.len] = 0;
+
+  memset(addr, 0, sizeof(struct sockaddr_storage));
+
+  struct sockaddr_in *addr_v4 = (struct sockaddr_in *)addr;
+  if (inet_pton(AF_INET, host_cp, &addr_v4->sin_addr) == 1) {
+    addr_v4->sin_family = AF_INET;
+    addr_v4->sin_port = htons(port);
+    return true;
+  }
+
+  struct sockaddr_in6 *addr_v6 = (struct sockaddr_in6 *)addr;
+  if (inet_pton(AF_INET6, host_cp, &addr_v6->sin6_addr) == 1) {
+    addr_v6->sin6_family = AF_INET6;
+    addr_v6->sin6_port = htons(port);
+    return true;
+  }
+
+  return false;
+}
+
+static inline void cmsc_decode_via_route_addr(struct cmsc_SipHeaderVia *via,
+                                              struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 3261 18.2.2 and RFC 3581 4 response goes to `received`
+    if present, otherwise to `sent-by` host. Port is taken from `rport`,
+    then from `sent-by` and in the end defaults to 5060 (5061 for TLS).
+      sent-by = host [ COLON port ]
+  */
+  struct cmsc_String sent_by = cmsc_bs_msg_to_string(&via->sent_by, msg);
+  struct cmsc_String port = {0};
+
+  cmsc_s_trimm(&sent_by, ' ');
+  struct cmsc_String host = sent_by;
+
+  const char *colon = NULL;
+  if (sent_by.len > 0 && *sent_by.buf == '[') {
+    const char *bracket = memchr(sent_by.buf, ']', sent_by.len);
+    if (bracket) {
+      host.len = bracket - sent_by.buf + 1;
+      if (host.len < sent_by.len && bracket[1] == ':') {
+        colon = bracket + 1;
+      }
+    }
+  } else {
+    colon = memchr(sent_by.buf, ':', sent_by.len);
+    // More than one colon means IPv6 address without brackets
+    if (colon &&
+        memchr(colon + 1, ':', sent_by.len - (colon + 1 - sent_by.buf))) {
+      colon = NULL;
+    } else if (colon) {
+      host.len = colon - sent_by.buf;
+    }
+  }
+
+  if (colon) {
+    port.buf = colon + 1;
+    port.len = sent_by.len - (port.buf - sent_by.buf);
+  }
+
+  uint32_t port_number = via->rport;
+  if (!port_number) {
+    port_number = cmsc_decode_port(port);
+  }
+  if (!port_number) {
+    struct cmsc_String proto = cmsc_bs_msg_to_string(&via->proto, msg);
+    port_number = (proto.len == 3 && strncasecmp(proto.buf, "TLS", 3) == 0)
+                      ? 5061
+                      : 5060;
+  }
+
+  if (via->received.len > 0) {
+    host = cmsc_bs_msg_to_string(&via->received, msg);
+  }
+
+  via->is_route_addr_resolved =
+      cmsc_decode_ip_addr(host, port_number, &via->route_addr);
+}
+
 #endif
@@ -10,112 +10,178 @@
 #include "c_minilib_error.h"
 #include "c_minilib_sip_codec.h"
 #include "utils/bstring.h"
+#include "utils/generated_codecs.h"
 #include "utils/buffer.h"
 #include "utils/sipmsg.h"
+#include "utils/registry.h"
+#include "utils/siptokens.h"
 #include "utils/tag_iterator.h"
+#include "utils/writer.h"
 #include <stdint.h>
 
 struct cmsc_EncoderLogic {
   cme_error_t (*encode_func)(const struct cmsc_SipMessage *,
-                             struct cmsc_Buffer *);
+                             struct cmsc_Writer *);
   enum cmsc_SupportedSipHeaders id;
 };
 
-static inline cme_error_t cmsc_encode_hdr_via(const struct cmsc_SipMessage *msg,
-                                              struct cmsc_Buffer *buf);
-static inline cme_error_t cmsc_encode_hdr_to(const struct cmsc_SipMessage *msg,
-                                             struct cmsc_Buffer *buf);
-static inline cme_error_t
-cmsc_encode_hdr_from(const struct cmsc_SipMessage *msg,
-                     struct cmsc_Buffer *buf);
-static inline cme_error_t
-cmsc_encode_hdr_call_id(const struct cmsc_SipMessage *msg,
-                        struct cmsc_Buffer *buf);
-static inline cme_error_t
-cmsc_encode_hdr_cseq(const struct cmsc_SipMessage *msg,
-                     struct cmsc_Buffer *buf);
+// Appends listed cmsc_String parts with one size check.
+#define CMSC_ENCODE_PARTS(writer, ...)                                         \
+  cmsc_writer_insert_parts(                                                    \
+      (const struct cmsc_String[]){__VA_ARGS__},                               \
+      sizeof((const struct cmsc_String[]){__VA_ARGS__}) /                      \
+          sizeof(struct cmsc_String),                                          \
+      writer)
+
+// Evaluates to `literal` only if `value` is not empty, for optional params.
+#define CMSC_ENCODE_IF_SET(literal, value)                                     \
+  ((value).len ? CMSC_BUFFER_LITERAL(literal) : CMSC_BUFFER_LITERAL(""))
+
+static inline struct cmsc_String
+cmsc_encode_bs(const struct cmsc_SipMessage *msg,
+               const struct cmsc_BString *value) {
+  return cmsc_bs_msg_to_string(value, (struct cmsc_SipMessage *)msg);
+}
+
+// Separates list elements, message in compact form drops the space.
+static inline struct cmsc_String
+cmsc_encode_list_separator(const struct cmsc_SipMessage *msg) {
+  return msg->is_compact_form ? CMSC_BUFFER_LITERAL(",")
+                              : CMSC_BUFFER_LITERAL(", ");
+}
+
+// Empty if header name has no compact form or is not well known.
+static inline struct cmsc_String cmsc_encode_compact_name(uint16_t id) {
+  static const struct cmsc_String compact_names[cmsc_HeaderNames_MAX] = {
+#define CMSC_X(hid, hname, hcompact_name)                                      \
+  [cmsc_HeaderNames_##hid] = {.buf = hcompact_name,                            \
+                              .len = sizeof(hcompact_name) - 1},
+      CMSC_HEADER_NAMES(CMSC_X)
+#undef CMSC_X
+  };
+
+  if (id >= cmsc_HeaderNames_MAX) {
+    return CMSC_BUFFER_LITERAL("");
+  }
+
+  return compact_names[id];
+}
+
+#define CMSC_X(id, suffix, field, type, name, compact_name, is_encoded)        \
+  CMSC_IF(is_encoded)(static inline cme_error_t cmsc_encode_hdr_##suffix(      \
+      const struct cmsc_SipMessage *msg, struct cmsc_Writer *writer);)
+CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
+
 static inline cme_error_t
-cmsc_encode_hdr_content_length(const struct cmsc_SipMessage *msg,
-                               struct cmsc_Buffer *buf);
+cmsc_encode_hdr_extensions(const struct cmsc_SipMessage *msg,
+                           struct cmsc_Writer *writer);
 
 static inline cme_error_t
 cmsc_encode_request_line(const struct cmsc_SipMessage *msg,
-                         struct cmsc_Buffer *buf) {
-  return cmsc_buffer_finsert(
-      buf, NULL, "%.*s %.*s %.*s\r\n", msg->request_line.sip_method.len,
-      cmsc_bs_msg_to_string(&msg->request_line.sip_method,
-                            (struct cmsc_SipMessage *)msg)
-          .buf,
-      msg->request_line.request_uri.len,
-      cmsc_bs_msg_to_string(&msg->request_line.request_uri,
-                            (struct cmsc_SipMessage *)msg)
-          .buf,
-      msg->request_line.sip_proto_ver.len,
-      cmsc_bs_msg_to_string(&msg->request_line.sip_proto_ver,
-                            (struct cmsc_SipMessage *)msg)
-          .buf);
+                         struct cmsc_Writer *writer) {
+  return CMSC_ENCODE_PARTS(
+      writer, cmsc_encode_bs(msg, &msg->request_line.sip_method),
+      CMSC_BUFFER_LITERAL(" "),
+      cmsc_encode_bs(msg, &msg->request_line.request_uri),
+      CMSC_BUFFER_LITERAL(" "),
+      cmsc_encode_bs(msg, &msg->request_line.sip_proto_ver),
+      CMSC_BUFFER_LITERAL("\r\n"));
 };
 
 static inline cme_error_t
 cmsc_encode_status_line(const struct cmsc_SipMessage *msg,
-                        struct cmsc_Buffer *buf) {
-  return cmsc_buffer_finsert(
-      buf, NULL, "%.*s %d %.*s\r\n", msg->status_line.sip_proto_ver.len,
-      cmsc_bs_msg_to_string(&msg->status_line.sip_proto_ver,
-                            (struct cmsc_SipMessage *)msg)
-          .buf,
-      msg->status_line.status_code, msg->status_line.reason_phrase.len,
-      cmsc_bs_msg_to_string(&msg->status_line.reason_phrase,
-                            (struct cmsc_SipMessage *)msg)
-          .buf);
+                        struct cmsc_Writer *writer) {
+  char status_code[CMSC_BUFFER_U32_SIZE];
+
+  return CMSC_ENCODE_PARTS(
+      writer, cmsc_encode_bs(msg, &msg->status_line.sip_proto_ver),
+      CMSC_BUFFER_LITERAL(" "),
+      cmsc_buffer_u32_to_string(msg->status_line.status_code, status_code),
+      CMSC_BUFFER_LITERAL(" "),
+      cmsc_encode_bs(msg, &msg->status_line.reason_phrase),
+      CMSC_BUFFER_LITERAL("\r\n"));
 };
 
 static inline cme_error_t
 cmsc_encode_generic_hdr(const struct cmsc_SipMessage *msg,
                         const struct cmsc_SipHeader *hdr,
-                        struct cmsc_Buffer *buf) {
-  return cmsc_buffer_finsert(
-      buf, NULL, "%.*s: %.*s\r\n", hdr->key.len,
-      cmsc_bs_msg_to_string(&hdr->key, (struct cmsc_SipMessage *)msg).buf,
-      hdr->value.len,
-      cmsc_bs_msg_to_string(&hdr->value, (struct cmsc_SipMessage *)msg).buf);
+                        struct cmsc_Writer *writer) {
+  struct cmsc_String name = cmsc_encode_bs(msg, &hdr->key);
+  struct cmsc_String separator = CMSC_BUFFER_LITERAL(": ");
+
+  if (msg->is_compact_form) {
+    struct cmsc_String compact_name = cmsc_encode_compact_name(hdr->id);
+    if (compact_name.len) {
+      name = compact_name;
+    }
+    separator = CMSC_BUFFER_LITERAL(":");
+  }
+
+  return CMSC_ENCODE_PARTS(writer, name, separator,
+                           cmsc_encode_bs(msg, &hdr->value),
+                           CMSC_BUFFER_LITERAL("\r\n"));
 };
 
+static inline const struct cmsc_EncoderLogic *
+cmsc_encoders_builtin(uint32_t *len) {
+  static const struct cmsc_EncoderLogic encoders[] = {
+#define CMSC_X(hid, suffix, field, type, name, compact_name, is_encoded)       \
+  CMSC_IF(is_encoded)({.encode_func = cmsc_encode_hdr_##suffix,                \
+                       .id = cmsc_SupportedSipHeaders_##hid}, )
+      CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
+  };
+
+  *len = sizeof(encoders) / sizeof(struct cmsc_EncoderLogic);
+  return encoders;
+}
+
+// Returns NULL if header with `id` is not encoded.
+static inline const struct cmsc_EncoderLogic *
+cmsc_encoder_find(enum cmsc_SupportedSipHeaders id) {
+  uint32_t encoders_len;
+  const struct cmsc_EncoderLogic *encoders =
+      cmsc_encoders_builtin(&encoders_len);
+
+  for (uint32_t i = 0; i < encoders_len; i++) {
+    if (encoders[i].id == id) {
+      return &encoders[i];
+    }
+  }
+
+  return NULL;
+}
+
 static inline cme_error_t
 cmsc_encode_sip_headers(const struct cmsc_SipMessage *msg,
-                        struct cmsc_Buffer *buf) {
-  static struct cmsc_EncoderLogic encoders[] = {
-      {.encode_func = cmsc_encode_hdr_via, .id = cmsc_SupportedSipHeaders_VIAS},
-      {.encode_func = cmsc_encode_hdr_to, .id = cmsc_SupportedSipHeaders_TO},
-      {.encode_func = cmsc_encode_hdr_from,
-       .id = cmsc_SupportedSipHeaders_FROM},
-      {.encode_func = cmsc_encode_hdr_call_id,
-       .id = cmsc_SupportedSipHeaders_CALL_ID},
-      {.encode_func = cmsc_encode_hdr_cseq,
-       .id = cmsc_SupportedSipHeaders_CSEQ},
-      {.encode_func = cmsc_encode_hdr_content_length,
-       .id = cmsc_SupportedSipHeaders_CONTENT_LENGTH},
-
-  };
+                        struct cmsc_Writer *writer) {
+  uint32_t encoders_len;
+  const struct cmsc_EncoderLogic *encoders =
+      cmsc_encoders_builtin(&encoders_len);
   cme_error_t err;
   if (!msg) {
     err = cme_error(EINVAL, "`msg` cannot be NULL");
     goto error_out;
   }
 
-  for (uint32_t i = 0; i < sizeof(encoders) / sizeof(struct cmsc_EncoderLogic);
-       i++) {
+  for (uint32_t i = 0; i < encoders_len; i++) {
     if (!cmsc_sipmsg_is_field_present((struct cmsc_SipMessage *)msg,
                                       encoders[i].id)) {
       continue;
     }
 
-    err = encoders[i].encode_func(msg, buf);
+    err = encoders[i].encode_func(msg, writer);
     if (err) {
       goto error_out;
     }
   }
 
+  err = cmsc_encode_hdr_extensions(msg, writer);
+  if (err) {
+    goto error_out;
+  }
+
   return 0;
 
 error_out:
@@ -123,119 +189,312 @@ error_out:
 };
 
 static inline cme_error_t cmsc_encode_hdr_to(const struct cmsc_SipMessage *msg,
-                                             struct cmsc_Buffer *buf) {
-  cme_error_t err;
-  if (msg->to.tag.len > 0) {
-    err = cmsc_buffer_finsert(
-        buf, NULL, "%.*s: %.*s;tag=%.*s\r\n", strlen("To"), "To",
-        msg->to.uri.len,
-        cmsc_bs_msg_to_string(&msg->to.uri, (struct cmsc_SipMessage *)msg).buf,
-        msg->to.tag.len,
-        cmsc_bs_msg_to_string(&msg->to.tag, (struct cmsc_SipMessage *)msg).buf);
-  } else {
-    err = cmsc_buffer_finsert(
-        buf, NULL, "%.*s: %.*s\r\n", strlen("To"), "To", msg->to.uri.len,
-        cmsc_bs_msg_to_string(&msg->to.uri, (struct cmsc_SipMessage *)msg).buf);
-  }
-
-  return err;
+                                             struct cmsc_Writer *writer) {
+  return CMSC_ENCODE_PARTS(
+      writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_TO),
+      cmsc_encode_bs(msg, &msg->to.uri),
+      CMSC_ENCODE_IF_SET(";tag=", msg->to.tag),
+      cmsc_encode_bs(msg, &msg->to.tag), CMSC_BUFFER_LITERAL("\r\n"));
 };
 
 static inline cme_error_t
 cmsc_encode_hdr_from(const struct cmsc_SipMessage *msg,
-                     struct cmsc_Buffer *buf) {
-  cme_error_t err;
-  if (msg->to.tag.len > 0) {
-    err = cmsc_buffer_finsert(
-        buf, NULL, "%.*s: %.*s;tag=%.*s\r\n", strlen("From"), "From",
-        msg->from.uri.len,
-        cmsc_bs_msg_to_string(&msg->from.uri, (struct cmsc_SipMessage *)msg)
-            .buf,
-        msg->from.tag.len,
-        cmsc_bs_msg_to_string(&msg->from.tag, (struct cmsc_SipMessage *)msg)
-            .buf);
-  } else {
-    err = cmsc_buffer_finsert(
-        buf, NULL, "%.*s: %.*s\r\n", strlen("From"), "From", msg->from.uri.len,
-        cmsc_bs_msg_to_string(&msg->from.uri, (struct cmsc_SipMessage *)msg)
-            .buf);
-  }
-
-  return cme_return(err);
+                     struct cmsc_Writer *writer) {
+  return CMSC_ENCODE_PARTS(
+      writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_FROM),
+      cmsc_encode_bs(msg, &msg->from.uri),
+      CMSC_ENCODE_IF_SET(";tag=", msg->from.tag),
+      cmsc_encode_bs(msg, &msg->from.tag), CMSC_BUFFER_LITERAL("\r\n"));
 };
 
 static inline cme_error_t
 cmsc_encode_hdr_call_id(const struct cmsc_SipMessage *msg,
-                        struct cmsc_Buffer *buf) {
-  return cmsc_buffer_finsert(
-      buf, NULL, "%.*s: %.*s\r\n", strlen("Call-ID"), "Call-ID",
-      msg->call_id.len,
-      cmsc_bs_msg_to_string(&msg->call_id, (struct cmsc_SipMessage *)msg).buf);
+                        struct cmsc_Writer *writer) {
+  return CMSC_ENCODE_PARTS(
+      writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_CALL_ID),
+      cmsc_encode_bs(msg, &msg->call_id), CMSC_BUFFER_LITERAL("\r\n"));
 };
 
 static inline cme_error_t
 cmsc_encode_hdr_cseq(const struct cmsc_SipMessage *msg,
-                     struct cmsc_Buffer *buf) {
-  return cmsc_buffer_finsert(
-      buf, NULL, "%.*s: %d %.*s\r\n", strlen("CSeq"), "CSeq",
-      msg->cseq.seq_number, msg->cseq.method.len,
-      cmsc_bs_msg_to_string(&msg->cseq.method, (struct cmsc_SipMessage *)msg)
-          .buf);
+                     struct cmsc_Writer *writer) {
+  char seq_number[CMSC_BUFFER_U32_SIZE];
+
+  return CMSC_ENCODE_PARTS(
+      writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_CSEQ),
+      cmsc_buffer_u32_to_string(msg->cseq.seq_number, seq_number),
+      CMSC_BUFFER_LITERAL(" "), cmsc_encode_bs(msg, &msg->cseq.method),
+      CMSC_BUFFER_LITERAL("\r\n"));
 };
 
 static inline cme_error_t cmsc_encode_hdr_via(const struct cmsc_SipMessage *msg,
-                                              struct cmsc_Buffer *buf) {
+                                              struct cmsc_Writer *writer) {
+  char ttl[CMSC_BUFFER_U32_SIZE];
+  char rport[CMSC_BUFFER_U32_SIZE];
   struct cmsc_SipHeaderVia *via;
   cme_error_t err;
   STAILQ_FOREACH(via, &msg->vias, _next) {
-    err = cmsc_buffer_finsert(
-        buf, NULL, "%.*s: %.*s %.*s", strlen("Via"), "Via", via->proto.len,
-        cmsc_bs_msg_to_string(&via->proto, (struct cmsc_SipMessage *)msg).buf,
-        via->sent_by.len,
-        cmsc_bs_msg_to_string(&via->sent_by, (struct cmsc_SipMessage *)msg)
-            .buf);
+    if (via->raw.len) {
+      err = CMSC_ENCODE_PARTS(
+          writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_VIAS),
+          cmsc_encode_bs(msg, &via->raw), CMSC_BUFFER_LITERAL("\r\n"));
+      if (err) {
+        goto error_out;
+      }
+      continue;
+    }
+
+    err = CMSC_ENCODE_PARTS(
+        writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_VIAS),
+        cmsc_encode_bs(msg, &via->proto),
+        CMSC_BUFFER_LITERAL(" "), cmsc_encode_bs(msg, &via->sent_by),
+        CMSC_ENCODE_IF_SET(";addr=", via->addr),
+        cmsc_encode_bs(msg, &via->addr),
+        CMSC_ENCODE_IF_SET(";branch=", via->branch),
+        cmsc_encode_bs(msg, &via->branch),
+        CMSC_ENCODE_IF_SET(";received=", via->received),
+        cmsc_encode_bs(msg, &via->received),
+        via->ttl ? CMSC_BUFFER_LITERAL(";ttl=") : CMSC_BUFFER_LITERAL(""),
+        via->ttl ? cmsc_buffer_u32_to_string(via->ttl, ttl)
+                 : CMSC_BUFFER_LITERAL(""),
+        via->has_rport ? CMSC_BUFFER_LITERAL(";rport")
+                       : CMSC_BUFFER_LITERAL(""),
+        via->has_rport && via->rport ? CMSC_BUFFER_LITERAL("=")
+                                     : CMSC_BUFFER_LITERAL(""),
+        via->has_rport && via->rport
+            ? cmsc_buffer_u32_to_string(via->rport, rport)
+            : CMSC_BUFFER_LITERAL(""),
+        CMSC_BUFFER_LITERAL("\r\n"));
     if (err) {
       goto error_out;
     }
+  }
 
-    if (via->addr.len) {
-      err = cmsc_buffer_finsert(
-          buf, NULL, ";addr=%.*s", via->addr.len,
-          cmsc_bs_msg_to_string(&via->addr, (struct cmsc_SipMessage *)msg).buf);
-      if (err) {
-        goto error_out;
-      }
+  return 0;
+
+error_out:
+  return cme_return(err);
+};
+
+static inline cme_error_t
+cmsc_encode_hdr_u32(const struct cmsc_String name, uint32_t value,
+                    struct cmsc_Writer *writer) {
+  char digits[CMSC_BUFFER_U32_SIZE];
+
+  return CMSC_ENCODE_PARTS(writer, name,
+                           cmsc_buffer_u32_to_string(value, digits),
+                           CMSC_BUFFER_LITERAL("\r\n"));
+}
+
+static inline cme_error_t
+cmsc_encode_hdr_content_length(const struct cmsc_SipMessage *msg,
+                               struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_u32(
+      cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_CONTENT_LENGTH),
+      msg->content_length, writer);
+}
+
+static inline cme_error_t
+cmsc_encode_hdr_max_forwards(const struct cmsc_SipMessage *msg,
+                             struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_u32(
+      cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_MAX_FORWARDS),
+      msg->max_forwards, writer);
+}
+
+static inline cme_error_t
+cmsc_encode_hdr_tokens(const struct cmsc_SipMessage *msg,
+                       const struct cmsc_String name,
+                       const struct cmsc_TokensTable *table,
+                       const struct cmsc_SipHeaderTokens *tokens,
+                       struct cmsc_Writer *writer) {
+  struct cmsc_String separator = CMSC_BUFFER_LITERAL("");
+  cme_error_t err;
+
+  err = CMSC_ENCODE_PARTS(writer, name);
+  if (err) {
+    goto error_out;
+  }
+
+  for (uint32_t i = 0; i < table->len; i++) {
+    if (!(tokens->mask & table->tokens[i].id)) {
+      continue;
     }
 
-    if (via->branch.len) {
-      err = cmsc_buffer_finsert(
-          buf, NULL, ";branch=%.*s", via->branch.len,
-          cmsc_bs_msg_to_string(&via->branch, (struct cmsc_SipMessage *)msg)
-              .buf);
-      if (err) {
-        goto error_out;
-      }
+    err = CMSC_ENCODE_PARTS(writer, separator, table->tokens[i].name);
+    if (err) {
+      goto error_out;
     }
+    separator = cmsc_encode_list_separator(msg);
+  }
 
-    if (via->received.len) {
-      err = cmsc_buffer_finsert(
-          buf, NULL, ";received=%.*s", via->received.len,
-          cmsc_bs_msg_to_string(&via->received, (struct cmsc_SipMessage *)msg)
-              .buf);
-      if (err) {
-        goto error_out;
-      }
+  struct cmsc_SipToken *token;
+  STAILQ_FOREACH(token, &tokens->unknown, _next) {
+    err = CMSC_ENCODE_PARTS(writer, separator,
+                            cmsc_encode_bs(msg, &token->token));
+    if (err) {
+      goto error_out;
+    }
+    separator = cmsc_encode_list_separator(msg);
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_ALLOW
+static inline cme_error_t
+cmsc_encode_hdr_allow(const struct cmsc_SipMessage *msg,
+                      struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_tokens(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_ALLOW),
+      cmsc_siptokens_methods(), &msg->allow, writer);
+}
+#endif
+
+#if CMSC_WITH_SUPPORTED
+static inline cme_error_t
+cmsc_encode_hdr_supported(const struct cmsc_SipMessage *msg,
+                          struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_tokens(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_SUPPORTED),
+      cmsc_siptokens_option_tags(), &msg->supported, writer);
+}
+#endif
+
+#if CMSC_WITH_REQUIRE
+static inline cme_error_t
+cmsc_encode_hdr_require(const struct cmsc_SipMessage *msg,
+                        struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_tokens(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_REQUIRE),
+      cmsc_siptokens_option_tags(), &msg->require, writer);
+}
+#endif
+
+#if CMSC_WITH_PROXY_REQUIRE
+static inline cme_error_t
+cmsc_encode_hdr_proxy_require(const struct cmsc_SipMessage *msg,
+                              struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_tokens(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_PROXY_REQUIRE),
+      cmsc_siptokens_option_tags(), &msg->proxy_require, writer);
+}
+#endif
+
+#if CMSC_WITH_UNSUPPORTED
+static inline cme_error_t
+cmsc_encode_hdr_unsupported(const struct cmsc_SipMessage *msg,
+                            struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_tokens(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_UNSUPPORTED),
+      cmsc_siptokens_option_tags(), &msg->unsupported, writer);
+}
+#endif
+
+static inline cme_error_t
+cmsc_encode_hdr_value_with_params(const struct cmsc_SipMessage *msg,
+                                  const struct cmsc_String name,
+                                  const struct cmsc_BString *value,
+                                  const struct cmsc_BString *params,
+                                  struct cmsc_Writer *writer) {
+  return CMSC_ENCODE_PARTS(writer, name, cmsc_encode_bs(msg, value),
+                           CMSC_ENCODE_IF_SET(";", *params),
+                           cmsc_encode_bs(msg, params),
+                           CMSC_BUFFER_LITERAL("\r\n"));
+}
+
+#if CMSC_WITH_CONTENT_TYPE
+static inline cme_error_t
+cmsc_encode_hdr_content_type(const struct cmsc_SipMessage *msg,
+                             struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_value_with_params(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_CONTENT_TYPE),
+      &msg->content_type.type, &msg->content_type.params, writer);
+}
+#endif
+
+#if CMSC_WITH_EVENT
+static inline cme_error_t
+cmsc_encode_hdr_event(const struct cmsc_SipMessage *msg,
+                      struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_value_with_params(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_EVENT),
+      &msg->event.package, &msg->event.params, writer);
+}
+#endif
+
+#if CMSC_WITH_SUBSCRIPTION_STATE
+static inline cme_error_t
+cmsc_encode_hdr_subscription_state(const struct cmsc_SipMessage *msg,
+                                   struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_value_with_params(
+      msg,
+      cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_SUBSCRIPTION_STATE),
+      &msg->subscription_state.state_name, &msg->subscription_state.params,
+      writer);
+}
+#endif
+
+#if CMSC_WITH_EXPIRES
+static inline cme_error_t
+cmsc_encode_hdr_expires(const struct cmsc_SipMessage *msg,
+                        struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_u32(
+      cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_EXPIRES),
+      msg->expires, writer);
+}
+#endif
+
+#if CMSC_WITH_MIN_EXPIRES
+static inline cme_error_t
+cmsc_encode_hdr_min_expires(const struct cmsc_SipMessage *msg,
+                            struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_u32(
+      cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_MIN_EXPIRES),
+      msg->min_expires, writer);
+}
+#endif
+
+static inline cme_error_t
+cmsc_encode_hdr_extensions(const struct cmsc_SipMessage *msg,
+                           struct cmsc_Writer *writer) {
+  cme_error_t err;
+
+  for (uint32_t slot = 0; slot < CMSC_MAX_EXTENSION_SLOTS; slot++) {
+    if (!(msg->extensions_mask & (1u << slot))) {
+      continue;
+    }
+
+    const struct cmsc_HeaderCodec *codec = cmsc_registry_get_codec(slot);
+    if (!codec) {
+      continue;
     }
 
-    if (via->ttl) {
-      err = cmsc_buffer_finsert(buf, NULL, ";ttl=%d", via->ttl);
+    const struct cmsc_SipHeaderExtension *extension = &msg->extensions[slot];
+    struct cmsc_String value = cmsc_bs_msg_to_string(
+        &extension->value, (struct cmsc_SipMessage *)msg);
+    if (codec->encode_func) {
+      err = codec->encode_func(msg, extension, &value);
       if (err) {
         goto error_out;
       }
     }
 
-    err = cmsc_buffer_insert(
-        (struct cmsc_String){.buf = "\r\n", .len = strlen("\r\n")}, buf, NULL);
+    err = CMSC_ENCODE_PARTS(
+        writer,
+        (struct cmsc_String){.buf = codec->name,
+                             .len = (uint32_t)strlen(codec->name)},
+        msg->is_compact_form ? CMSC_BUFFER_LITERAL(":")
+                             : CMSC_BUFFER_LITERAL(": "),
+        value, CMSC_BUFFER_LITERAL("\r\n"));
     if (err) {
       goto error_out;
     }
@@ -245,14 +504,221 @@ static inline cme_error_t cmsc_encode_hdr_via(const struct cmsc_SipMessage *msg,
 
 error_out:
   return cme_return(err);
-};
+}
 
 static inline cme_error_t
-cmsc_encode_hdr_content_length(const struct cmsc_SipMessage *msg,
-                               struct cmsc_Buffer *buf) {
-  return cmsc_buffer_finsert(buf, NULL, "%.*s: %u\r\n",
-                             strlen("Content-Length"), "Content-Length",
-                             msg->content_length);
+cmsc_encode_name_addr(const struct cmsc_SipMessage *msg,
+                      const struct cmsc_String separator,
+                      const struct cmsc_BString *display_name,
+                      const struct cmsc_BString *uri,
+                      const struct cmsc_BString *params,
+                      struct cmsc_Writer *writer) {
+  const struct cmsc_BString no_params = {0};
+  if (!params) {
+    params = &no_params;
+  }
+
+  return CMSC_ENCODE_PARTS(writer, separator,
+                           CMSC_ENCODE_IF_SET("\"", *display_name),
+                           cmsc_encode_bs(msg, display_name),
+                           CMSC_ENCODE_IF_SET("\" ", *display_name),
+                           CMSC_BUFFER_LITERAL("<"), cmsc_encode_bs(msg, uri),
+                           CMSC_BUFFER_LITERAL(">"),
+                           CMSC_ENCODE_IF_SET(";", *params),
+                           cmsc_encode_bs(msg, params));
+}
+
+static inline cme_error_t
+cmsc_encode_hdr_identities(const struct cmsc_SipMessage *msg,
+                           const struct cmsc_String name,
+                           const struct cmsc_SipIdentitiesList *identities,
+                           struct cmsc_Writer *writer) {
+  struct cmsc_String separator = CMSC_BUFFER_LITERAL("");
+  cme_error_t err;
+
+  err = CMSC_ENCODE_PARTS(writer, name);
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderIdentity *identity;
+  STAILQ_FOREACH(identity, identities, _next) {
+    if (identity->is_name_addr || identity->display_name.len) {
+      err = cmsc_encode_name_addr(msg, separator, &identity->display_name,
+                                  &identity->uri, &identity->params, writer);
+    } else {
+      err = CMSC_ENCODE_PARTS(writer, separator,
+                              cmsc_encode_bs(msg, &identity->uri),
+                              CMSC_ENCODE_IF_SET(";", identity->params),
+                              cmsc_encode_bs(msg, &identity->params));
+    }
+    if (err) {
+      goto error_out;
+    }
+    separator = cmsc_encode_list_separator(msg);
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_P_ASSERTED_IDENTITY
+static inline cme_error_t
+cmsc_encode_hdr_p_asserted_identity(const struct cmsc_SipMessage *msg,
+                                    struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_identities(
+      msg,
+      cmsc_writer_header_name(msg,
+                              cmsc_SupportedSipHeaders_P_ASSERTED_IDENTITY),
+      &msg->p_asserted_identities, writer);
+}
+#endif
+
+#if CMSC_WITH_P_PREFERRED_IDENTITY
+static inline cme_error_t
+cmsc_encode_hdr_p_preferred_identity(const struct cmsc_SipMessage *msg,
+                                     struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_identities(
+      msg,
+      cmsc_writer_header_name(msg,
+                              cmsc_SupportedSipHeaders_P_PREFERRED_IDENTITY),
+      &msg->p_preferred_identities, writer);
 }
+#endif
+
+#if CMSC_WITH_ROUTE || CMSC_WITH_RECORD_ROUTE
+static inline cme_error_t
+cmsc_encode_hdr_routes(const struct cmsc_SipMessage *msg,
+                       const struct cmsc_String name,
+                       const struct cmsc_SipRoutesList *routes,
+                       struct cmsc_Writer *writer) {
+  struct cmsc_String separator = CMSC_BUFFER_LITERAL("");
+  cme_error_t err;
+
+  err = CMSC_ENCODE_PARTS(writer, name);
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderRoute *route;
+  STAILQ_FOREACH(route, routes, _next) {
+    err = cmsc_encode_name_addr(msg, separator, &route->display_name,
+                                &route->uri, &route->params, writer);
+    if (err) {
+      goto error_out;
+    }
+    separator = cmsc_encode_list_separator(msg);
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_ROUTE
+static inline cme_error_t
+cmsc_encode_hdr_route(const struct cmsc_SipMessage *msg,
+                      struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_routes(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_ROUTE),
+      &msg->routes, writer);
+}
+#endif
+
+#if CMSC_WITH_RECORD_ROUTE
+static inline cme_error_t
+cmsc_encode_hdr_record_route(const struct cmsc_SipMessage *msg,
+                             struct cmsc_Writer *writer) {
+  return cmsc_encode_hdr_routes(
+      msg, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_RECORD_ROUTE),
+      &msg->record_routes, writer);
+}
+#endif
+
+#if CMSC_WITH_DIVERSION
+static inline cme_error_t
+cmsc_encode_hdr_diversion(const struct cmsc_SipMessage *msg,
+                          struct cmsc_Writer *writer) {
+  struct cmsc_String separator = CMSC_BUFFER_LITERAL("");
+  cme_error_t err;
+
+  err = CMSC_ENCODE_PARTS(
+      writer, cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_DIVERSION));
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderDiversion *diversion;
+  STAILQ_FOREACH(diversion, &msg->diversions, _next) {
+    err = cmsc_encode_name_addr(msg, separator, &diversion->display_name,
+                                &diversion->uri, &diversion->params, writer);
+    if (err) {
+      goto error_out;
+    }
+    separator = cmsc_encode_list_separator(msg);
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_HISTORY_INFO
+static inline cme_error_t
+cmsc_encode_hdr_history_info(const struct cmsc_SipMessage *msg,
+                             struct cmsc_Writer *writer) {
+  struct cmsc_String separator = CMSC_BUFFER_LITERAL("");
+  cme_error_t err;
+
+  err = CMSC_ENCODE_PARTS(
+      writer,
+      cmsc_writer_header_name(msg, cmsc_SupportedSipHeaders_HISTORY_INFO));
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderHistoryInfo *history_info;
+  STAILQ_FOREACH(history_info, &msg->history_infos, _next) {
+    err = cmsc_encode_name_addr(msg, separator, &history_info->display_name,
+                                &history_info->uri, &history_info->params,
+                                writer);
+    if (err) {
+      goto error_out;
+    }
+    separator = cmsc_encode_list_separator(msg);
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
 
 #endif
@@ -7,6 +7,9 @@
 #ifndef C_MINILIB_SIP_CODEC_GENERATOR_H
 #define C_MINILIB_SIP_CODEC_GENERATOR_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "c_minilib_error.h"
 #include "c_minilib_sip_codec.h"
 #include "utils/encoder.h"
@@ -14,18 +17,18 @@
 
 static inline cme_error_t
 cmsc_generate_first_line(const struct cmsc_SipMessage *msg,
-                         struct cmsc_Buffer *buf) {
+                         struct cmsc_Writer *writer) {
   cme_error_t err;
   if (cmsc_sipmsg_is_field_present((struct cmsc_SipMessage *)msg,
                                    cmsc_SupportedSipHeaders_REQUEST_LINE)) {
-    err = cmsc_encode_request_line(msg, buf);
+    err = cmsc_encode_request_line(msg, writer);
     if (err) {
       goto error_out;
     }
   } else if (cmsc_sipmsg_is_field_present(
                  (struct cmsc_SipMessage *)msg,
                  cmsc_SupportedSipHeaders_STATUS_LINE)) {
-    err = cmsc_encode_status_line(msg, buf);
+    err = cmsc_encode_status_line(msg, writer);
     if (err) {
       goto error_out;
     }
@@ -41,14 +44,19 @@ error_out:
   return cme_return(err);
 }
 
+// Generates headers with key at `offset` or later, parsed ones lie before it.
 static inline cme_error_t
 cmsc_generate_generic_headers(const struct cmsc_SipMessage *msg,
-                              struct cmsc_Buffer *buf) {
+                              uint32_t offset, struct cmsc_Writer *writer) {
 
   cme_error_t err;
   struct cmsc_SipHeader *hdr;
   STAILQ_FOREACH(hdr, &msg->sip_headers, _next) {
-    err = cmsc_encode_generic_hdr(msg, hdr, buf);
+    if (hdr->key.buf_offset < offset) {
+      continue;
+    }
+
+    err = cmsc_encode_generic_hdr(msg, hdr, writer);
     if (err) {
       goto error_out;
     }
@@ -61,17 +69,187 @@ error_out:
 }
 
 static inline cme_error_t cmsc_generate_body(const struct cmsc_SipMessage *msg,
-                                             struct cmsc_Buffer *buf) {
+                                             struct cmsc_Writer *writer) {
   cme_error_t err;
   if (cmsc_sipmsg_is_field_present((struct cmsc_SipMessage *)msg,
                                    cmsc_SupportedSipHeaders_CONTENT_LENGTH) &&
       msg->content_length > 0) {
-    err = cmsc_buffer_insert(
-        cmsc_bs_msg_to_string(&msg->body, (struct cmsc_SipMessage *)msg), buf,
-        NULL);
+    err = CMSC_ENCODE_PARTS(writer, cmsc_encode_bs(msg, &msg->body));
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#define CMSC_GENERATE_FIRST_LINE                                               \
+  (cmsc_SupportedSipHeaders_REQUEST_LINE | cmsc_SupportedSipHeaders_STATUS_LINE)
+
+#if CMSC_WITH_PASS_THROUGH
+// Parsed lines are reused if enabled, unless message has to be fully generated.
+static inline bool
+cmsc_generate_is_pass_through(const struct cmsc_SipMessage *msg) {
+  return msg->is_pass_through && msg->_lines_len && !msg->_is_lines_invalid &&
+         !msg->is_compact_form;
+}
+
+// Fields without encoder keep their parsed line even if they are dirty.
+static inline bool
+cmsc_generate_is_line_dirty(const struct cmsc_SipMessage *msg,
+                            const struct cmsc_SipLine *line) {
+  if (!(line->field & msg->dirty_mask)) {
+    return false;
+  }
+
+  return (line->field & CMSC_GENERATE_FIRST_LINE) ||
+         cmsc_encoder_find(line->field);
+}
+
+static inline cme_error_t
+cmsc_generate_dirty_field(const struct cmsc_SipMessage *msg, uint32_t field,
+                          struct cmsc_Writer *writer) {
+  if (field & CMSC_GENERATE_FIRST_LINE) {
+    return cmsc_generate_first_line(msg, writer);
+  }
+
+  return cmsc_encoder_find(field)->encode_func(msg, writer);
+}
+
+/* Copies parsed lines in original order, adjacent clean lines are copied at
+   once. Dirty field is encoded in place of its first line and its other lines
+   are skipped, lines of fields which are no longer present are dropped. */
+static inline cme_error_t
+cmsc_generate_pass_through(const struct cmsc_SipMessage *msg,
+                           struct cmsc_Writer *writer) {
+  struct cmsc_String clean = {.buf = msg->_buf.buf, .len = 0};
+  uint32_t seen_mask = 0;
+  cme_error_t err;
+
+  for (uint32_t i = 0; i < msg->_lines_len; i++) {
+    const struct cmsc_SipLine *line = &msg->_lines[i];
+    bool is_present = !line->field || (line->field & msg->presence_mask);
+    bool is_seen = line->field & seen_mask;
+    seen_mask |= line->field;
+
+    if (is_present && !cmsc_generate_is_line_dirty(msg, line)) {
+      const char *line_buf = msg->_buf.buf + line->offset;
+      if (clean.buf + clean.len == line_buf) {
+        clean.len += line->len;
+        continue;
+      }
+
+      err = CMSC_ENCODE_PARTS(writer, clean);
+      if (err) {
+        goto error_out;
+      }
+
+      clean = (struct cmsc_String){.buf = line_buf, .len = line->len};
+      continue;
+    }
+
+    err = CMSC_ENCODE_PARTS(writer, clean);
     if (err) {
       goto error_out;
     }
+    clean.len = 0;
+
+    if (is_present && !is_seen) {
+      err = cmsc_generate_dirty_field(msg, line->field, writer);
+      if (err) {
+        goto error_out;
+      }
+    }
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, clean);
+  if (err) {
+    goto error_out;
+  }
+
+  // Fields added after parsing follow original lines
+  uint32_t encoders_len;
+  const struct cmsc_EncoderLogic *encoders =
+      cmsc_encoders_builtin(&encoders_len);
+  for (uint32_t i = 0; i < encoders_len; i++) {
+    if ((encoders[i].id & seen_mask) ||
+        !(encoders[i].id & msg->dirty_mask & msg->presence_mask)) {
+      continue;
+    }
+
+    err = encoders[i].encode_func(msg, writer);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  const struct cmsc_SipLine *last = &msg->_lines[msg->_lines_len - 1];
+  err = cmsc_generate_generic_headers(msg, last->offset + last->len, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#endif
+
+// Encodes first line and headers field by field.
+static inline cme_error_t
+cmsc_generate_fields(const struct cmsc_SipMessage *msg,
+                     struct cmsc_Writer *writer) {
+  cme_error_t err;
+
+  err = cmsc_generate_first_line(msg, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_encode_sip_headers(msg, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_generate_generic_headers(msg, 0, writer);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static inline cme_error_t cmsc_generate_msg(const struct cmsc_SipMessage *msg,
+                                            struct cmsc_Writer *writer) {
+  cme_error_t err;
+
+#if CMSC_WITH_PASS_THROUGH
+  err = cmsc_generate_is_pass_through(msg)
+            ? cmsc_generate_pass_through(msg, writer)
+            : cmsc_generate_fields(msg, writer);
+#else
+  err = cmsc_generate_fields(msg, writer);
+#endif
+  if (err) {
+    goto error_out;
+  }
+
+  err = CMSC_ENCODE_PARTS(writer, CMSC_BUFFER_LITERAL("\r\n"));
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_generate_body(msg, writer);
+  if (err) {
+    goto error_out;
   }
 
   return 0;
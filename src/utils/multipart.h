@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_MULTIPART_H
+#define C_MINILIB_SIP_CODEC_MULTIPART_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+#include "utils/bstring.h"
+#include "utils/decoder.h"
+
+// Checks what follows dash-boundary, so `--b1extra` is not a delimiter.
+static inline bool cmsc_multipart_is_delimiter_end(const char *cursor,
+                                                   const char *end) {
+  /*
+    According RFC 2046 5.1.1 dash-boundary is followed by:
+      close-delimiter := delimiter "--"
+      encapsulation := delimiter transport-padding CRLF body-part
+      transport-padding := *LWSP-char
+  */
+  if (end - cursor >= 2 && cursor[0] == '-' && cursor[1] == '-') {
+    return true;
+  }
+
+  while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+    cursor++;
+  }
+  if (cursor < end && *cursor == '\r') {
+    cursor++;
+  }
+
+  return cursor < end && *cursor == '\n';
+}
+
+/*
+  According RFC 2046 5.1.1 delimiter has to start a line:
+    delimiter := CRLF dash-boundary
+    dash-boundary := "--" boundary
+  First delimiter may start the body as well. Candidates are found with
+  memchr which libc vectorizes, so the body is not scanned byte by byte here.
+*/
+static inline const char *
+cmsc_multipart_find_delimiter(const char *start, const char *end,
+                              const char *body_start,
+                              const struct cmsc_String boundary) {
+  const uint32_t delimiter_len = boundary.len + 2;
+  const char *cursor = start;
+
+  while ((uint32_t)(end - cursor) >= delimiter_len) {
+    cursor = memchr(cursor, '-', (end - cursor) - delimiter_len + 1);
+    if (!cursor) {
+      return NULL;
+    }
+
+    if (cursor[1] == '-' &&
+        memcmp(cursor + 2, boundary.buf, boundary.len) == 0 &&
+        (cursor == body_start || cursor[-1] == '\n') &&
+        cmsc_multipart_is_delimiter_end(cursor + delimiter_len, end)) {
+      return cursor;
+    }
+
+    cursor++;
+  }
+
+  return NULL;
+}
+
+static inline void cmsc_multipart_parse_part(struct cmsc_String part,
+                                             struct cmsc_MultipartPart *result,
+                                             struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 2046 5.1.1 part looks like this:
+      body-part := MIME-part-headers [CRLF *OCTET]
+    Part without empty line consists of headers only.
+  */
+  struct cmsc_String rest = part;
+  struct cmsc_String headers = part;
+  struct cmsc_String body = {0};
+
+  while (rest.len > 0) {
+    const char *lf = memchr(rest.buf, '\n', rest.len);
+    struct cmsc_String line = {
+        .buf = rest.buf, .len = lf ? (uint32_t)(lf - rest.buf) : rest.len};
+    if (line.len > 0 && line.buf[line.len - 1] == '\r') {
+      line.len--;
+    }
+
+    rest.len -= lf ? (uint32_t)(lf + 1 - rest.buf) : rest.len;
+    rest.buf = lf ? lf + 1 : rest.buf + rest.len;
+
+    if (line.len == 0) {
+      headers.len = line.buf - part.buf;
+      body = rest;
+      break;
+    }
+
+    const char *colon = memchr(line.buf, ':', line.len);
+    if (!colon) {
+      continue;
+    }
+
+    struct cmsc_String name = {.buf = line.buf, .len = colon - line.buf};
+    cmsc_s_trimm_spaces(&name);
+    if (!cmsc_s_equal_nocase(name, "Content-Type")) {
+      continue;
+    }
+
+    struct cmsc_String type = {.buf = colon + 1,
+                               .len = line.len - (colon + 1 - line.buf)};
+    struct cmsc_String params = {0};
+    const char *semicolon = memchr(type.buf, ';', type.len);
+    if (semicolon) {
+      params.buf = semicolon + 1;
+      params.len = type.len - (semicolon + 1 - type.buf);
+      type.len = semicolon - type.buf;
+    }
+
+    result->content_type.type = cmsc_s_msg_to_bstring(&type, msg);
+    result->content_type.params = cmsc_s_msg_to_bstring(&params, msg);
+    cmsc_decode_content_type(&result->content_type, msg);
+  }
+
+  // Line break before empty line belongs to it, not to headers
+  if (headers.len > 0 && headers.buf[headers.len - 1] == '\n') {
+    headers.len--;
+  }
+  if (headers.len > 0 && headers.buf[headers.len - 1] == '\r') {
+    headers.len--;
+  }
+
+  result->headers = cmsc_s_msg_to_bstring(&headers, msg);
+  result->body = cmsc_s_msg_to_bstring(&body, msg);
+}
+
+#if CMSC_WITH_CONTENT_TYPE
+static inline cme_error_t
+cmsc_multipart_parse(struct cmsc_SipMessage *msg,
+                     struct cmsc_MultipartBody *multipart) {
+  /*
+    According RFC 2046 5.1.1 multipart body looks like this:
+      multipart-body := [preamble CRLF]
+                        dash-boundary transport-padding CRLF
+                        body-part *encapsulation
+                        close-delimiter transport-padding
+                        [CRLF epilogue]
+      encapsulation := delimiter transport-padding CRLF body-part
+      close-delimiter := delimiter "--"
+  */
+  struct cmsc_String boundary =
+      cmsc_bs_msg_to_string(&msg->content_type.boundary, msg);
+  struct cmsc_String body = cmsc_bs_msg_to_string(&msg->body, msg);
+  const char *end = body.buf + body.len;
+  cme_error_t err;
+
+  memset(multipart, 0, sizeof(struct cmsc_MultipartBody));
+
+  if (!boundary.len) {
+    err = cme_error(EINVAL, "Missing boundary in Content-Type");
+    goto error_out;
+  }
+
+  const char *delimiter =
+      cmsc_multipart_find_delimiter(body.buf, end, body.buf, boundary);
+  if (!delimiter) {
+    err = cme_error(EINVAL, "Missing multipart delimiter");
+    goto error_out;
+  }
+
+  while (true) {
+    const char *cursor = delimiter + boundary.len + 2;
+    if (end - cursor >= 2 && cursor[0] == '-' && cursor[1] == '-') {
+      break;
+    }
+
+    // Skip transport padding
+    const char *lf = memchr(cursor, '\n', end - cursor);
+    if (!lf) {
+      err = cme_error(EINVAL, "Missing multipart close delimiter");
+      goto error_out;
+    }
+
+    const char *part_start = lf + 1;
+    delimiter =
+        cmsc_multipart_find_delimiter(part_start, end, body.buf, boundary);
+    if (!delimiter) {
+      err = cme_error(EINVAL, "Missing multipart close delimiter");
+      goto error_out;
+    }
+
+    // Line break before delimiter belongs to delimiter
+    const char *part_end = delimiter;
+    if (part_end > part_start && part_end[-1] == '\n') {
+      part_end--;
+    }
+    if (part_end > part_start && part_end[-1] == '\r') {
+      part_end--;
+    }
+
+    if (multipart->parts_len >= CMSC_MULTIPART_MAX_PARTS) {
+      err = cme_error(ENOBUFS, "Too many parts in multipart body");
+      goto error_out;
+    }
+
+    cmsc_multipart_parse_part(
+        (struct cmsc_String){.buf = part_start, .len = part_end - part_start},
+        &multipart->parts[multipart->parts_len++], msg);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#endif
@@ -17,6 +17,7 @@
 #include "c_minilib_error.h"
 #include "c_minilib_sip_codec.h"
 #include "utils/bstring.h"
+#include "utils/registry.h"
 #include "utils/siphdr.h"
 #include "utils/sipmsg.h"
 
@@ -43,6 +44,8 @@ static inline cme_error_t cmsc_parse_sip_headers(struct cmsc_Buffer *buf,
         if (err) {
           goto error_out;
         }
+        header->id = cmsc_registry_find_id((struct cmsc_String){
+            .buf = line_start, .len = current_char - line_start});
         clrf_counter = 0;
       }
       break;
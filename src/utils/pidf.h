@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_PIDF_H
+#define C_MINILIB_SIP_CODEC_PIDF_H
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+#include "utils/bstring.h"
+
+struct cmsc_PidfElement {
+  struct cmsc_String name;
+  // Where element's text should be stored, NULL if it is not needed
+  struct cmsc_BString *text;
+  const char *text_start;
+};
+
+static inline bool cmsc_pidf_starts_with(const char *start, const char *end,
+                                         const char *literal) {
+  const size_t literal_len = strlen(literal);
+  return (size_t)(end - start) >= literal_len &&
+         memcmp(start, literal, literal_len) == 0;
+}
+
+static inline const char *cmsc_pidf_find(const char *start, const char *end,
+                                         const char *literal) {
+  while ((start = memchr(start, literal[0], end - start))) {
+    if (cmsc_pidf_starts_with(start, end, literal)) {
+      return start;
+    }
+    start++;
+  }
+
+  return NULL;
+}
+
+// Namespace prefix is dropped, so `rpid:away` becomes `away`.
+static inline struct cmsc_String cmsc_pidf_local_name(struct cmsc_String name) {
+  const char *colon = memchr(name.buf, ':', name.len);
+  if (colon) {
+    name.len -= colon + 1 - name.buf;
+    name.buf = colon + 1;
+  }
+
+  return name;
+}
+
+static inline bool cmsc_pidf_find_attribute(struct cmsc_String attrs,
+                                            const char *name,
+                                            struct cmsc_String *value) {
+  const char *cursor = attrs.buf;
+  const char *end = attrs.buf + attrs.len;
+
+  while (cursor < end) {
+    while (cursor < end && isspace(*cursor)) {
+      cursor++;
+    }
+
+    const char *equal = memchr(cursor, '=', end - cursor);
+    if (!equal) {
+      return false;
+    }
+
+    struct cmsc_String attr_name = {.buf = cursor, .len = equal - cursor};
+    cmsc_s_trimm_spaces(&attr_name);
+
+    cursor = equal + 1;
+    while (cursor < end && isspace(*cursor)) {
+      cursor++;
+    }
+    if (cursor == end || (*cursor != '"' && *cursor != '\'')) {
+      return false;
+    }
+
+    const char *closing_quote = memchr(cursor + 1, *cursor, end - cursor - 1);
+    if (!closing_quote) {
+      return false;
+    }
+
+    if (cmsc_s_equal_nocase(cmsc_pidf_local_name(attr_name), name)) {
+      value->buf = cursor + 1;
+      value->len = closing_quote - value->buf;
+      return true;
+    }
+
+    cursor = closing_quote + 1;
+  }
+
+  return false;
+}
+
+static inline cme_error_t
+cmsc_pidf_open_element(struct cmsc_String name, struct cmsc_String parent,
+                       struct cmsc_String attrs, struct cmsc_PidfTuple **tuple,
+                       struct cmsc_PidfPresence *pidf,
+                       struct cmsc_SipMessage *msg,
+                       struct cmsc_BString **text) {
+  struct cmsc_String value;
+  cme_error_t err;
+
+  *text = NULL;
+
+  if (cmsc_s_equal_nocase(name, "presence")) {
+    if (cmsc_pidf_find_attribute(attrs, "entity", &value)) {
+      pidf->entity = cmsc_s_msg_to_bstring(&value, msg);
+    }
+  } else if (cmsc_s_equal_nocase(name, "tuple")) {
+    if (pidf->tuples_len >= CMSC_PIDF_MAX_TUPLES) {
+      err = cme_error(ENOBUFS, "Too many tuples in pidf");
+      goto error_out;
+    }
+    *tuple = &pidf->tuples[pidf->tuples_len++];
+    if (cmsc_pidf_find_attribute(attrs, "id", &value)) {
+      (*tuple)->id = cmsc_s_msg_to_bstring(&value, msg);
+    }
+  } else if (*tuple && cmsc_s_equal_nocase(name, "basic") &&
+             cmsc_s_equal_nocase(parent, "status")) {
+    *text = &(*tuple)->basic;
+  } else if (*tuple && cmsc_s_equal_nocase(name, "contact") &&
+             cmsc_s_equal_nocase(parent, "tuple")) {
+    *text = &(*tuple)->contact;
+  } else if (cmsc_s_equal_nocase(name, "note")) {
+    if (*tuple && cmsc_s_equal_nocase(parent, "tuple")) {
+      *text = &(*tuple)->note;
+    } else if (cmsc_s_equal_nocase(parent, "presence") ||
+               cmsc_s_equal_nocase(parent, "person")) {
+      *text = &pidf->note;
+    }
+  } else if (cmsc_s_equal_nocase(parent, "activities")) {
+    if (pidf->activities_len >= CMSC_PIDF_MAX_ACTIVITIES) {
+      err = cme_error(ENOBUFS, "Too many activities in pidf");
+      goto error_out;
+    }
+    pidf->activities[pidf->activities_len++] =
+        cmsc_s_msg_to_bstring(&name, msg);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static inline cme_error_t cmsc_pidf_parse(struct cmsc_SipMessage *msg,
+                                          struct cmsc_PidfPresence *pidf) {
+  struct cmsc_PidfElement stack[CMSC_PIDF_MAX_DEPTH];
+  struct cmsc_String body = cmsc_bs_msg_to_string(&msg->body, msg);
+  const char *end = body.buf + body.len;
+  const char *cursor = body.buf;
+  struct cmsc_PidfTuple *tuple = NULL;
+  uint32_t depth = 0;
+  cme_error_t err;
+
+  memset(pidf, 0, sizeof(struct cmsc_PidfPresence));
+
+  while ((cursor = memchr(cursor, '<', end - cursor))) {
+    const char *tag = cursor + 1;
+    const char *close;
+
+    // Comments, CDATA, declarations and processing instructions are skipped.
+    // DTD is never processed, so entities cannot expand.
+    if (cmsc_pidf_starts_with(tag, end, "!--")) {
+      close = cmsc_pidf_find(tag, end, "-->");
+    } else if (cmsc_pidf_starts_with(tag, end, "![CDATA[")) {
+      close = cmsc_pidf_find(tag, end, "]]>");
+    } else {
+      close = memchr(tag, '>', end - tag);
+      // DOCTYPE internal subset may contain '>' itself
+      const char *subset =
+          close && *tag == '!' ? memchr(tag, '[', close - tag) : NULL;
+      if (subset) {
+        close = cmsc_pidf_find(subset, end, "]>");
+      }
+    }
+    if (!close) {
+      err = cme_error(EINVAL, "Unterminated pidf markup");
+      goto error_out;
+    }
+
+    if (*tag == '!' || *tag == '?') {
+      cursor = memchr(close, '>', end - close) + 1;
+      continue;
+    }
+
+    struct cmsc_String content = {.buf = tag, .len = close - tag};
+    cursor = close + 1;
+
+    if (*tag == '/') {
+      content.buf++;
+      content.len--;
+      cmsc_s_trimm_spaces(&content);
+      content = cmsc_pidf_local_name(content);
+
+      if (depth == 0 || content.len != stack[depth - 1].name.len ||
+          memcmp(content.buf, stack[depth - 1].name.buf, content.len) != 0) {
+        err = cme_errorf(EINVAL, "Unexpected pidf end tag: %.*s", content.len,
+                         content.buf);
+        goto error_out;
+      }
+
+      struct cmsc_PidfElement *element = &stack[--depth];
+      if (element->text) {
+        struct cmsc_String text = {.buf = element->text_start,
+                                   .len = (tag - 1) - element->text_start};
+        cmsc_s_trimm_spaces(&text);
+        *element->text = cmsc_s_msg_to_bstring(&text, msg);
+      }
+      if (cmsc_s_equal_nocase(element->name, "tuple")) {
+        tuple = NULL;
+      }
+      continue;
+    }
+
+    bool is_self_closing =
+        content.len > 0 && content.buf[content.len - 1] == '/';
+    if (is_self_closing) {
+      content.len--;
+    }
+
+    struct cmsc_String name = content;
+    struct cmsc_String attrs = {0};
+    for (uint32_t i = 0; i < content.len; i++) {
+      if (isspace(content.buf[i])) {
+        name.len = i;
+        attrs.buf = content.buf + i;
+        attrs.len = content.len - i;
+        break;
+      }
+    }
+    name = cmsc_pidf_local_name(name);
+
+    struct cmsc_BString *text;
+    err = cmsc_pidf_open_element(
+        name, depth ? stack[depth - 1].name : (struct cmsc_String){0}, attrs,
+        &tuple, pidf, msg, &text);
+    if (err) {
+      goto error_out;
+    }
+
+    if (is_self_closing) {
+      if (cmsc_s_equal_nocase(name, "tuple")) {
+        tuple = NULL;
+      }
+      continue;
+    }
+
+    if (depth >= CMSC_PIDF_MAX_DEPTH) {
+      err = cme_error(ENOBUFS, "Pidf elements nested too deep");
+      goto error_out;
+    }
+
+    stack[depth++] = (struct cmsc_PidfElement){
+        .name = name, .text = text, .text_start = cursor};
+  }
+
+  if (depth != 0) {
+    err = cme_error(EINVAL, "Unterminated pidf element");
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#endif
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+
+#include "utils/bstring.h"
+#include "utils/decoder.h"
+#include "utils/registry.h"
+
+// Has to be power of two, table is kept at most half full.
+#ifndef CMSC_REGISTRY_SIZE
+#define CMSC_REGISTRY_SIZE 512
+#endif
+
+#define CMSC_REGISTRY_IDS_MAX                                                  \
+  (cmsc_HeaderNames_MAX + CMSC_MAX_EXTENSION_SLOTS)
+
+struct cmsc_RegistryName {
+  struct cmsc_String name;
+  uint16_t id;
+};
+
+static struct cmsc_RegistryName cmsc_registry[CMSC_REGISTRY_SIZE];
+static struct cmsc_DecoderLogic cmsc_registry_decoders[CMSC_REGISTRY_IDS_MAX];
+static struct cmsc_HeaderCodec cmsc_registry_codecs[CMSC_MAX_EXTENSION_SLOTS];
+static uint32_t cmsc_registry_len = 0;
+static bool cmsc_registry_is_built = false;
+
+static struct cmsc_RegistryName *
+cmsc_registry_lookup(const struct cmsc_String header_name) {
+  uint32_t i = cmsc_s_hash_nocase(header_name) & (CMSC_REGISTRY_SIZE - 1);
+  while (cmsc_registry[i].name.len) {
+    if (cmsc_registry[i].name.len == header_name.len &&
+        strncasecmp(cmsc_registry[i].name.buf, header_name.buf,
+                    header_name.len) == 0) {
+      break;
+    }
+    i = (i + 1) & (CMSC_REGISTRY_SIZE - 1);
+  }
+
+  return &cmsc_registry[i];
+}
+
+static cme_error_t cmsc_registry_insert(const struct cmsc_String header_name,
+                                        uint16_t id) {
+  struct cmsc_RegistryName *entry = cmsc_registry_lookup(header_name);
+  cme_error_t err;
+
+  if (entry->name.len) {
+    if (entry->id == id) {
+      return 0;
+    }
+    err = cme_errorf(EEXIST, "Header %.*s is already registered",
+                     header_name.len, header_name.buf);
+    goto error_out;
+  }
+
+  if (cmsc_registry_len >= CMSC_REGISTRY_SIZE / 2) {
+    err = cme_error(ENOBUFS, "Headers registry is full");
+    goto error_out;
+  }
+
+  *entry = (struct cmsc_RegistryName){.name = header_name, .id = id};
+  cmsc_registry_len++;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_registry_init(void) {
+  static const struct cmsc_RegistryName names[] = {
+#define CMSC_X(hid, hname, hcompact_name)                                      \
+  {.name = {.buf = hname, .len = sizeof(hname) - 1},                           \
+   .id = cmsc_HeaderNames_##hid},                                              \
+  {.name = {.buf = hcompact_name, .len = sizeof(hcompact_name) - 1},           \
+   .id = cmsc_HeaderNames_##hid},
+      CMSC_HEADER_NAMES(CMSC_X)
+#undef CMSC_X
+  };
+  cme_error_t err;
+
+  if (cmsc_registry_is_built) {
+    return 0;
+  }
+
+  // Names without compact form produce empty entry, they are skipped.
+  for (uint32_t i = 0; i < sizeof(names) / sizeof(struct cmsc_RegistryName);
+       i++) {
+    if (!names[i].name.len) {
+      continue;
+    }
+
+    err = cmsc_registry_insert(names[i].name, names[i].id);
+    if (err) {
+      goto error_registry_cleanup;
+    }
+  }
+
+  uint32_t decoders_len;
+  const struct cmsc_DecoderLogic *decoders =
+      cmsc_decoders_builtin(&decoders_len);
+  for (uint32_t i = 0; i < decoders_len; i++) {
+    if (!decoders[i].header_id.len) {
+      continue;
+    }
+
+    struct cmsc_RegistryName *entry =
+        cmsc_registry_lookup(decoders[i].header_id);
+    if (!entry->name.len) {
+      err = cme_errorf(ENOENT, "Decoded header %.*s is not in header names",
+                       decoders[i].header_id.len, decoders[i].header_id.buf);
+      goto error_registry_cleanup;
+    }
+
+    cmsc_registry_decoders[entry->id] = decoders[i];
+  }
+
+  cmsc_registry_is_built = true;
+
+  return 0;
+
+error_registry_cleanup:
+  cmsc_registry_destroy();
+  return cme_return(err);
+}
+
+void cmsc_registry_destroy(void) {
+  memset(cmsc_registry, 0, sizeof(cmsc_registry));
+  memset(cmsc_registry_decoders, 0, sizeof(cmsc_registry_decoders));
+  memset(cmsc_registry_codecs, 0, sizeof(cmsc_registry_codecs));
+  cmsc_registry_len = 0;
+  cmsc_registry_is_built = false;
+}
+
+bool cmsc_registry_is_ready(void) { return cmsc_registry_is_built; }
+
+/* Registry is built only in cmsc_init, building it lazily here would race
+   when first messages are parsed by more threads at once. */
+uint16_t cmsc_registry_find_id(const struct cmsc_String header_name) {
+  return cmsc_registry_lookup(header_name)->id;
+}
+
+const struct cmsc_DecoderLogic *cmsc_registry_get_decoder(uint16_t id) {
+  if (id == cmsc_HeaderNames_UNKNOWN || id >= CMSC_REGISTRY_IDS_MAX ||
+      (!cmsc_registry_decoders[id].decode_func &&
+       !cmsc_registry_decoders[id].codec)) {
+    return NULL;
+  }
+
+  return &cmsc_registry_decoders[id];
+}
+
+const struct cmsc_HeaderCodec *cmsc_registry_get_codec(uint32_t slot) {
+  if (slot >= CMSC_MAX_EXTENSION_SLOTS || !cmsc_registry_codecs[slot].name) {
+    return NULL;
+  }
+
+  return &cmsc_registry_codecs[slot];
+}
+
+/* Registered name keeps its id if it is well known, it can be registered only
+   if no built-in decoder handles it already. */
+cme_error_t cmsc_register_header(const struct cmsc_HeaderCodec *codec) {
+  cme_error_t err;
+  if (!codec || !codec->name || !*codec->name) {
+    err = cme_error(EINVAL, "`codec` and `codec->name` cannot be NULL");
+    goto error_out;
+  }
+
+  if (codec->slot >= CMSC_MAX_EXTENSION_SLOTS) {
+    err = cme_errorf(EINVAL, "Slot %u exceeds CMSC_MAX_EXTENSION_SLOTS",
+                     codec->slot);
+    goto error_out;
+  }
+
+  if (cmsc_registry_codecs[codec->slot].name) {
+    err = cme_errorf(EEXIST, "Slot %u is already registered", codec->slot);
+    goto error_out;
+  }
+
+  if (!cmsc_registry_is_built) {
+    err = cme_error(EINVAL, "Headers have to be registered after cmsc_init");
+    goto error_out;
+  }
+
+  struct cmsc_String header_name = {.buf = codec->name,
+                                    .len = strlen(codec->name)};
+  uint16_t id = cmsc_registry_lookup(header_name)->id;
+  if (id == cmsc_HeaderNames_UNKNOWN) {
+    id = cmsc_HeaderNames_MAX + codec->slot;
+    err = cmsc_registry_insert(header_name, id);
+    if (err) {
+      goto error_out;
+    }
+  } else if (cmsc_registry_get_decoder(id)) {
+    err = cme_errorf(EEXIST, "Header %s is already registered", codec->name);
+    goto error_out;
+  }
+
+  cmsc_registry_codecs[codec->slot] = *codec;
+  cmsc_registry_decoders[id] = (struct cmsc_DecoderLogic){
+      .header_id = header_name, .codec = &cmsc_registry_codecs[codec->slot]};
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_REGISTRY_H
+#define C_MINILIB_SIP_CODEC_REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+
+struct cmsc_DecoderLogic {
+  struct cmsc_String header_id;
+  cme_error_t (*decode_func)(const struct cmsc_SipHeader *sip_header,
+                             struct cmsc_SipMessage *msg);
+  // Field decoded by `decode_func`, NONE for registered headers
+  enum cmsc_SupportedSipHeaders field;
+  // Set only for headers registered with cmsc_register_header
+  const struct cmsc_HeaderCodec *codec;
+};
+
+/* Builds hash table of header names, does nothing if already built. It is
+   called only from cmsc_init, as it is not thread safe. */
+cme_error_t cmsc_registry_init(void);
+void cmsc_registry_destroy(void);
+
+// Returns false until cmsc_registry_init succeeds.
+bool cmsc_registry_is_ready(void);
+
+// Returns cmsc_HeaderNames_UNKNOWN if name is neither known nor registered.
+uint16_t cmsc_registry_find_id(const struct cmsc_String header_name);
+
+// Returns NULL if header with `id` is not decoded.
+const struct cmsc_DecoderLogic *cmsc_registry_get_decoder(uint16_t id);
+
+// Returns NULL if slot is not registered.
+const struct cmsc_HeaderCodec *cmsc_registry_get_codec(uint32_t slot);
+
+#endif
@@ -0,0 +1,424 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_SDP_H
+#define C_MINILIB_SIP_CODEC_SDP_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+#include "utils/bstring.h"
+
+// Lines are terminated by CRLF, but RFC 4566 5 allows plain LF as well.
+static inline bool cmsc_sdp_next_line(struct cmsc_String *body,
+                                      struct cmsc_String *line) {
+  if (body->len == 0) {
+    return false;
+  }
+
+  const char *lf = memchr(body->buf, '\n', body->len);
+  uint32_t line_len = lf ? (uint32_t)(lf - body->buf) : body->len;
+
+  line->buf = body->buf;
+  line->len = line_len;
+  if (line->len > 0 && line->buf[line->len - 1] == '\r') {
+    line->len--;
+  }
+
+  if (lf) {
+    line_len++;
+  }
+  body->buf += line_len;
+  body->len -= line_len;
+
+  return true;
+}
+
+// Fields are separated by single space, `field` is empty if none left.
+static inline bool cmsc_sdp_next_field(struct cmsc_String *src,
+                                       struct cmsc_String *field) {
+  while (src->len > 0 && *src->buf == ' ') {
+    src->buf++;
+    src->len--;
+  }
+
+  if (src->len == 0) {
+    *field = (struct cmsc_String){0};
+    return false;
+  }
+
+  const char *space = memchr(src->buf, ' ', src->len);
+  field->buf = src->buf;
+  field->len = space ? (uint32_t)(space - src->buf) : src->len;
+
+  src->buf += field->len;
+  src->len -= field->len;
+
+  return true;
+}
+
+static inline struct cmsc_BString
+cmsc_sdp_next_bfield(struct cmsc_String *src, struct cmsc_SipMessage *msg) {
+  struct cmsc_String field;
+  cmsc_sdp_next_field(src, &field);
+  return cmsc_s_msg_to_bstring(&field, msg);
+}
+
+// Returns false if field is missing or is not a number.
+static inline bool cmsc_sdp_next_ufield(struct cmsc_String *src,
+                                        uint32_t *result) {
+  struct cmsc_String field;
+
+  cmsc_sdp_next_field(src, &field);
+  return cmsc_s_to_uint32(field, result);
+}
+
+static inline void cmsc_sdp_parse_connection(struct cmsc_String value,
+                                             struct cmsc_SdpConnection *conn,
+                                             struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 4566 5.7 connection looks like this:
+      c=<nettype> <addrtype> <connection-address>
+  */
+  conn->net_type = cmsc_sdp_next_bfield(&value, msg);
+  conn->addr_type = cmsc_sdp_next_bfield(&value, msg);
+  conn->address = cmsc_sdp_next_bfield(&value, msg);
+}
+
+static inline void cmsc_sdp_parse_origin(struct cmsc_String value,
+                                         struct cmsc_SdpOrigin *origin,
+                                         struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 4566 5.2 origin looks like this:
+      o=<username> <sess-id> <sess-version> <nettype> <addrtype>
+        <unicast-address>
+  */
+  origin->username = cmsc_sdp_next_bfield(&value, msg);
+  origin->session_id = cmsc_sdp_next_bfield(&value, msg);
+  origin->session_version = cmsc_sdp_next_bfield(&value, msg);
+  origin->net_type = cmsc_sdp_next_bfield(&value, msg);
+  origin->addr_type = cmsc_sdp_next_bfield(&value, msg);
+  origin->address = cmsc_sdp_next_bfield(&value, msg);
+}
+
+static inline cme_error_t cmsc_sdp_parse_media(struct cmsc_String value,
+                                               struct cmsc_SdpMedia *media,
+                                               struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 4566 5.14 media looks like this:
+      m=<media> <port>/<number of ports> <proto> <fmt> ...
+  */
+  struct cmsc_String port;
+
+  media->media = cmsc_sdp_next_bfield(&value, msg);
+  cmsc_sdp_next_field(&value, &port);
+  media->proto = cmsc_sdp_next_bfield(&value, msg);
+  if (!media->media.len || !port.len || !media->proto.len) {
+    return cme_error(EINVAL, "Malformed sdp media line");
+  }
+
+  const char *slash = memchr(port.buf, '/', port.len);
+  if (slash) {
+    cmsc_s_to_uint32(
+        (struct cmsc_String){.buf = slash + 1,
+                             .len = port.len - (slash + 1 - port.buf)},
+        &media->ports_count);
+    port.len = slash - port.buf;
+  }
+  cmsc_s_to_uint32(port, &media->port);
+
+  cmsc_s_trimm_spaces(&value);
+  media->formats = cmsc_s_msg_to_bstring(&value, msg);
+
+  return 0;
+}
+
+static inline cme_error_t
+cmsc_sdp_parse_rtpmap(struct cmsc_String value, struct cmsc_SdpMedia *media,
+                      struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 4566 6 rtpmap looks like this:
+      a=rtpmap:<payload type> <encoding name>/<clock rate>
+        [/<encoding parameters>]
+  */
+  if (media->rtpmaps_len >= CMSC_SDP_MAX_RTPMAPS) {
+    return cme_error(ENOBUFS, "Too many rtpmap attributes in sdp media");
+  }
+
+  struct cmsc_SdpRtpMap rtpmap = {0};
+  struct cmsc_String encoding;
+  struct cmsc_String clock_rate;
+
+  if (!cmsc_sdp_next_ufield(&value, &rtpmap.payload_type) ||
+      !cmsc_sdp_next_field(&value, &encoding)) {
+    return cme_error(EINVAL, "Malformed sdp rtpmap");
+  }
+
+  const char *slash = memchr(encoding.buf, '/', encoding.len);
+  if (!slash) {
+    return cme_error(EINVAL, "Malformed sdp rtpmap");
+  }
+  clock_rate.buf = slash + 1;
+  clock_rate.len = encoding.len - (clock_rate.buf - encoding.buf);
+  encoding.len = slash - encoding.buf;
+
+  slash = memchr(clock_rate.buf, '/', clock_rate.len);
+  if (slash) {
+    struct cmsc_String encoding_params = {
+        .buf = slash + 1, .len = clock_rate.len - (slash + 1 - clock_rate.buf)};
+    rtpmap.encoding_params = cmsc_s_msg_to_bstring(&encoding_params, msg);
+    clock_rate.len = slash - clock_rate.buf;
+  }
+
+  if (!encoding.len || !cmsc_s_to_uint32(clock_rate, &rtpmap.clock_rate)) {
+    return cme_error(EINVAL, "Malformed sdp rtpmap");
+  }
+
+  rtpmap.encoding = cmsc_s_msg_to_bstring(&encoding, msg);
+  media->rtpmaps[media->rtpmaps_len++] = rtpmap;
+
+  return 0;
+}
+
+static inline cme_error_t cmsc_sdp_parse_fmtp(struct cmsc_String value,
+                                              struct cmsc_SdpMedia *media,
+                                              struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 4566 6 fmtp looks like this:
+      a=fmtp:<format> <format specific parameters>
+  */
+  if (media->fmtps_len >= CMSC_SDP_MAX_FMTPS) {
+    return cme_error(ENOBUFS, "Too many fmtp attributes in sdp media");
+  }
+
+  struct cmsc_SdpFmtp fmtp = {0};
+
+  if (!cmsc_sdp_next_ufield(&value, &fmtp.payload_type)) {
+    return cme_error(EINVAL, "Malformed sdp fmtp");
+  }
+
+  cmsc_s_trimm_spaces(&value);
+  if (!value.len) {
+    return cme_error(EINVAL, "Malformed sdp fmtp");
+  }
+
+  fmtp.params = cmsc_s_msg_to_bstring(&value, msg);
+  media->fmtps[media->fmtps_len++] = fmtp;
+
+  return 0;
+}
+
+static inline cme_error_t
+cmsc_sdp_parse_candidate(struct cmsc_String value, struct cmsc_SdpMedia *media,
+                         struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 8839 5.1 candidate looks like this:
+      candidate-attribute = "candidate" ":" foundation SP component-id SP
+                            transport SP priority SP connection-address SP
+                            port SP cand-type ...
+      cand-type           = "typ" SP candidate-types
+  */
+  if (media->candidates_len >= CMSC_SDP_MAX_CANDIDATES) {
+    return cme_error(ENOBUFS, "Too many candidate attributes in sdp media");
+  }
+
+  struct cmsc_SdpCandidate candidate = {0};
+  struct cmsc_String typ;
+
+  candidate.foundation = cmsc_sdp_next_bfield(&value, msg);
+  if (!candidate.foundation.len ||
+      !cmsc_sdp_next_ufield(&value, &candidate.component)) {
+    goto error_out;
+  }
+
+  candidate.transport = cmsc_sdp_next_bfield(&value, msg);
+  if (!candidate.transport.len ||
+      !cmsc_sdp_next_ufield(&value, &candidate.priority)) {
+    goto error_out;
+  }
+
+  candidate.address = cmsc_sdp_next_bfield(&value, msg);
+  if (!candidate.address.len ||
+      !cmsc_sdp_next_ufield(&value, &candidate.port)) {
+    goto error_out;
+  }
+
+  cmsc_sdp_next_field(&value, &typ);
+  candidate.type = cmsc_sdp_next_bfield(&value, msg);
+  if (!cmsc_s_equal_nocase(typ, "typ") || !candidate.type.len) {
+    goto error_out;
+  }
+
+  media->candidates[media->candidates_len++] = candidate;
+
+  return 0;
+
+error_out:
+  return cme_error(EINVAL, "Malformed sdp candidate");
+}
+
+static inline cme_error_t
+cmsc_sdp_parse_attribute(struct cmsc_String value, struct cmsc_SdpSession *sdp,
+                         struct cmsc_SdpMedia *media,
+                         struct cmsc_SipMessage *msg) {
+  /*
+    According RFC 4566 5.13 attribute looks like this:
+      a=<attribute>
+      a=<attribute>:<value>
+  */
+  static const struct {
+    const char *name;
+    enum cmsc_SdpDirections direction;
+  } directions[] = {
+      {"sendrecv", cmsc_SdpDirections_SENDRECV},
+      {"sendonly", cmsc_SdpDirections_SENDONLY},
+      {"recvonly", cmsc_SdpDirections_RECVONLY},
+      {"inactive", cmsc_SdpDirections_INACTIVE},
+  };
+  struct cmsc_String name = value;
+  struct cmsc_String attr_value = {0};
+
+  const char *colon = memchr(value.buf, ':', value.len);
+  if (colon) {
+    name.len = colon - value.buf;
+    attr_value.buf = colon + 1;
+    attr_value.len = value.len - (name.len + 1);
+  }
+
+  for (uint32_t i = 0; i < sizeof(directions) / sizeof(directions[0]); i++) {
+    if (cmsc_s_equal_nocase(name, directions[i].name)) {
+      if (media) {
+        media->direction = directions[i].direction;
+      } else {
+        sdp->direction = directions[i].direction;
+      }
+      return 0;
+    }
+  }
+
+  if (media) {
+    if (cmsc_s_equal_nocase(name, "rtpmap")) {
+      return cmsc_sdp_parse_rtpmap(attr_value, media, msg);
+    }
+
+    if (cmsc_s_equal_nocase(name, "fmtp")) {
+      return cmsc_sdp_parse_fmtp(attr_value, media, msg);
+    }
+
+    if (cmsc_s_equal_nocase(name, "candidate")) {
+      return cmsc_sdp_parse_candidate(attr_value, media, msg);
+    }
+
+    if (cmsc_s_equal_nocase(name, "rtcp")) {
+      // a=rtcp:<port> [<nettype> <addrtype> <connection-address>]
+      if (!cmsc_sdp_next_ufield(&attr_value, &media->rtcp_port)) {
+        return cme_error(EINVAL, "Malformed sdp rtcp");
+      }
+      cmsc_sdp_parse_connection(attr_value, &media->rtcp_connection, msg);
+      return 0;
+    }
+  }
+
+  uint32_t *attributes_len = media ? &media->attributes_len
+                                   : &sdp->attributes_len;
+  struct cmsc_SdpAttribute *attributes =
+      media ? media->attributes : sdp->attributes;
+  if (*attributes_len >= CMSC_SDP_MAX_ATTRIBUTES) {
+    return cme_error(ENOBUFS, "Too many attributes in sdp");
+  }
+
+  attributes[*attributes_len].name = cmsc_s_msg_to_bstring(&name, msg);
+  attributes[*attributes_len].value = cmsc_s_msg_to_bstring(&attr_value, msg);
+  (*attributes_len)++;
+
+  return 0;
+}
+
+static inline cme_error_t cmsc_sdp_parse(struct cmsc_SipMessage *msg,
+                                         struct cmsc_SdpSession *sdp) {
+  struct cmsc_String body = cmsc_bs_msg_to_string(&msg->body, msg);
+  struct cmsc_SdpMedia *media = NULL;
+  struct cmsc_String line;
+  cme_error_t err;
+
+  memset(sdp, 0, sizeof(struct cmsc_SdpSession));
+
+  while (cmsc_sdp_next_line(&body, &line)) {
+    if (line.len == 0) {
+      continue;
+    }
+
+    if (line.len < 2 || line.buf[1] != '=') {
+      err = cme_errorf(EINVAL, "Malformed sdp line: %.*s", line.len, line.buf);
+      goto error_out;
+    }
+
+    struct cmsc_String value = {.buf = line.buf + 2, .len = line.len - 2};
+
+    switch (line.buf[0]) {
+    case 'v':
+      cmsc_s_to_uint32(value, &sdp->version);
+      break;
+    case 'o':
+      cmsc_sdp_parse_origin(value, &sdp->origin, msg);
+      break;
+    case 's':
+      sdp->session_name = cmsc_s_msg_to_bstring(&value, msg);
+      break;
+    case 'c':
+      cmsc_sdp_parse_connection(value,
+                                media ? &media->connection : &sdp->connection,
+                                msg);
+      break;
+    case 't':
+      // Only first timing is kept, repeated ones are rare in SIP
+      if (!sdp->timing.start.len) {
+        sdp->timing.start = cmsc_sdp_next_bfield(&value, msg);
+        sdp->timing.stop = cmsc_sdp_next_bfield(&value, msg);
+      }
+      break;
+    case 'm':
+      if (sdp->medias_len >= CMSC_SDP_MAX_MEDIAS) {
+        err = cme_error(ENOBUFS, "Too many medias in sdp");
+        goto error_out;
+      }
+      media = &sdp->medias[sdp->medias_len++];
+      err = cmsc_sdp_parse_media(value, media, msg);
+      if (err) {
+        goto error_out;
+      }
+      break;
+    case 'a':
+      err = cmsc_sdp_parse_attribute(value, sdp, media, msg);
+      if (err) {
+        goto error_out;
+      }
+      break;
+    default:;
+    }
+  }
+
+  // Session level connection and direction are defaults for each media
+  for (uint32_t i = 0; i < sdp->medias_len; i++) {
+    if (!sdp->medias[i].connection.address.len) {
+      sdp->medias[i].connection = sdp->connection;
+    }
+    if (sdp->medias[i].direction == cmsc_SdpDirections_NONE) {
+      sdp->medias[i].direction = sdp->direction;
+    }
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#endif
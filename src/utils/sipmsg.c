@@ -8,6 +8,8 @@
 #include "c_minilib_sip_codec.h"
 
 #include "utils/buffer.h"
+#include "utils/decoder.h"
+#include "utils/registry.h"
 #include "utils/siphdr.h"
 #include "utils/sipmsg.h"
 #include <stdint.h>
@@ -38,6 +40,72 @@ error_out:
   return cme_return(err);
 }
 
+/* Parsed message borrows user buffer, it is copied before first insert so user
+   memory is never reallocated. Offsets stay valid in the copy. */
+static cme_error_t cmsc_sipmsg_binsert(const struct cmsc_String value,
+                                       struct cmsc_SipMessage *msg,
+                                       struct cmsc_BString *result) {
+  cme_error_t err;
+
+  if (msg->_parsed_buf && msg->_buf.buf == msg->_parsed_buf) {
+    uint32_t size = msg->_buf.len + value.len + CMSC_SIPMSG_DEFAULT_BUF_SIZE;
+    char *buf = malloc(size);
+    if (!buf) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `buf`");
+      goto error_out;
+    }
+
+    memcpy(buf, msg->_buf.buf, msg->_buf.len);
+    msg->_buf.buf = buf;
+    msg->_buf.size = size;
+  }
+
+  err = cmsc_buffer_binsert(value, &msg->_buf, result);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_ALLOW || CMSC_WITH_SUPPORTED || CMSC_WITH_REQUIRE ||             \
+    CMSC_WITH_PROXY_REQUIRE || CMSC_WITH_UNSUPPORTED
+static void cmsc_sipmsg_destroy_tokens(struct cmsc_SipHeaderTokens *tokens) {
+  struct cmsc_SipToken *token;
+  while (!STAILQ_EMPTY(&tokens->unknown)) {
+    token = STAILQ_FIRST(&tokens->unknown);
+    STAILQ_REMOVE_HEAD(&tokens->unknown, _next);
+    free(token);
+  }
+}
+#endif
+
+#if CMSC_WITH_ROUTE || CMSC_WITH_RECORD_ROUTE
+static void cmsc_sipmsg_destroy_routes(struct cmsc_SipRoutesList *routes) {
+  struct cmsc_SipHeaderRoute *route;
+  while (!STAILQ_EMPTY(routes)) {
+    route = STAILQ_FIRST(routes);
+    STAILQ_REMOVE_HEAD(routes, _next);
+    free(route);
+  }
+}
+#endif
+
+#if CMSC_WITH_P_ASSERTED_IDENTITY || CMSC_WITH_P_PREFERRED_IDENTITY
+static void
+cmsc_sipmsg_destroy_identities(struct cmsc_SipIdentitiesList *identities) {
+  struct cmsc_SipHeaderIdentity *identity;
+  while (!STAILQ_EMPTY(identities)) {
+    identity = STAILQ_FIRST(identities);
+    STAILQ_REMOVE_HEAD(identities, _next);
+    free(identity);
+  }
+}
+#endif
+
 // This function assumes user keeps ownership over _buf memory
 void cmsc_sipmsg_destroy(struct cmsc_SipMessage **msg) {
   if (!msg || !*msg) {
@@ -58,6 +126,73 @@ void cmsc_sipmsg_destroy(struct cmsc_SipMessage **msg) {
     free(via);
   }
 
+#if CMSC_WITH_ROUTE
+  cmsc_sipmsg_destroy_routes(&(*msg)->routes);
+#endif
+#if CMSC_WITH_RECORD_ROUTE
+  cmsc_sipmsg_destroy_routes(&(*msg)->record_routes);
+#endif
+
+#if CMSC_WITH_ALLOW
+  cmsc_sipmsg_destroy_tokens(&(*msg)->allow);
+#endif
+#if CMSC_WITH_SUPPORTED
+  cmsc_sipmsg_destroy_tokens(&(*msg)->supported);
+#endif
+#if CMSC_WITH_REQUIRE
+  cmsc_sipmsg_destroy_tokens(&(*msg)->require);
+#endif
+#if CMSC_WITH_PROXY_REQUIRE
+  cmsc_sipmsg_destroy_tokens(&(*msg)->proxy_require);
+#endif
+#if CMSC_WITH_UNSUPPORTED
+  cmsc_sipmsg_destroy_tokens(&(*msg)->unsupported);
+#endif
+
+#if CMSC_WITH_P_ASSERTED_IDENTITY
+  cmsc_sipmsg_destroy_identities(&(*msg)->p_asserted_identities);
+#endif
+#if CMSC_WITH_P_PREFERRED_IDENTITY
+  cmsc_sipmsg_destroy_identities(&(*msg)->p_preferred_identities);
+#endif
+
+#if CMSC_WITH_DIVERSION
+  struct cmsc_SipHeaderDiversion *diversion;
+  while (!STAILQ_EMPTY(&(*msg)->diversions)) {
+    diversion = STAILQ_FIRST(&(*msg)->diversions);
+    STAILQ_REMOVE_HEAD(&(*msg)->diversions, _next);
+    free(diversion);
+  }
+#endif
+
+#if CMSC_WITH_HISTORY_INFO
+  struct cmsc_SipHeaderHistoryInfo *history_info;
+  while (!STAILQ_EMPTY(&(*msg)->history_infos)) {
+    history_info = STAILQ_FIRST(&(*msg)->history_infos);
+    STAILQ_REMOVE_HEAD(&(*msg)->history_infos, _next);
+    free(history_info);
+  }
+#endif
+
+  for (uint32_t slot = 0; slot < CMSC_MAX_EXTENSION_SLOTS; slot++) {
+    const struct cmsc_HeaderCodec *codec = cmsc_registry_get_codec(slot);
+    if (((*msg)->extensions_mask & (1u << slot)) && codec &&
+        codec->destroy_func) {
+      codec->destroy_func(&(*msg)->extensions[slot]);
+    }
+  }
+
+  if ((*msg)->_parsed_buf && (*msg)->_buf.buf != (*msg)->_parsed_buf) {
+    free((void *)(*msg)->_buf.buf);
+  }
+
+#if CMSC_WITH_HEADERS_INDEX
+  free((*msg)->_headers_index);
+#endif
+#if CMSC_WITH_PASS_THROUGH
+  free((*msg)->_lines);
+#endif
+
   free(*msg);
 
   *msg = NULL;
@@ -70,7 +205,8 @@ void cmsc_sipmsg_destroy_with_buf(struct cmsc_SipMessage **msg) {
     return;
   }
 
-  free((void *)(*msg)->_buf.buf);
+  // Copy of parsed buffer is released by cmsc_sipmsg_destroy
+  free((void *)((*msg)->_parsed_buf ? (*msg)->_parsed_buf : (*msg)->_buf.buf));
 
   cmsc_sipmsg_destroy(msg);
 }
@@ -93,25 +229,25 @@ cmsc_sipmsg_insert_request_line(uint32_t sip_ver_len, const char *sip_ver,
   }
 
   // Insert Sip Version
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = sip_ver, .len = sip_ver_len}, &msg->_buf,
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = sip_ver, .len = sip_ver_len}, msg,
       &msg->request_line.sip_proto_ver);
   if (err) {
     goto error_out;
   }
 
   // Insert Request Uri
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = req_uri, .len = req_uri_len}, &msg->_buf,
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = req_uri, .len = req_uri_len}, msg,
       &msg->request_line.request_uri);
   if (err) {
     goto error_out;
   }
 
   // Insert Method
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = sip_method, .len = sip_method_len},
-      &msg->_buf, &msg->request_line.sip_method);
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = sip_method, .len = sip_method_len}, msg,
+      &msg->request_line.sip_method);
   if (err) {
     goto error_out;
   }
@@ -144,17 +280,17 @@ cme_error_t cmsc_sipmsg_insert_status_line(uint32_t sip_ver_len,
   }
 
   // Insert Sip Version
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = sip_ver, .len = sip_ver_len}, &msg->_buf,
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = sip_ver, .len = sip_ver_len}, msg,
       &msg->status_line.sip_proto_ver);
   if (err) {
     goto error_out;
   }
 
   // Insert Reason Phrase
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = reason_phrase, .len = reason_phrase_len},
-      &msg->_buf, &msg->status_line.reason_phrase);
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = reason_phrase, .len = reason_phrase_len}, msg,
+      &msg->status_line.reason_phrase);
   if (err) {
     goto error_out;
   }
@@ -184,17 +320,16 @@ cme_error_t cmsc_sipmsg_insert_header(uint32_t key_len, const char *key,
   }
 
   struct cmsc_BString msg_key = {0};
-  err = cmsc_buffer_binsert((struct cmsc_String){.buf = key, .len = key_len},
-                            &msg->_buf, &msg_key);
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = key, .len = key_len},
+                            msg, &msg_key);
   if (err) {
     goto error_out;
   }
 
   struct cmsc_BString msg_value = {0};
   if (value) {
-    err = cmsc_buffer_binsert(
-        (struct cmsc_String){.buf = value, .len = value_len}, &msg->_buf,
-        &msg_value);
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.buf = value, .len = value_len}, msg, &msg_value);
     if (err) {
       goto error_out;
     }
@@ -206,8 +341,15 @@ cme_error_t cmsc_sipmsg_insert_header(uint32_t key_len, const char *key,
   if (err) {
     goto error_out;
   }
+  sip_hdr->id =
+      cmsc_registry_find_id((struct cmsc_String){.buf = key, .len = key_len});
 
   STAILQ_INSERT_TAIL(&msg->sip_headers, sip_hdr, _next);
+#if CMSC_WITH_HEADERS_INDEX
+  if (msg->_headers_index && !cmsc_sipmsg_index_header(sip_hdr, msg)) {
+    cmsc_sipmsg_index_destroy(msg);
+  }
+#endif
 
   return 0;
 
@@ -215,6 +357,56 @@ error_out:
   return cme_return(err);
 };
 
+struct cmsc_SipHeader *cmsc_sipmsg_find_header(struct cmsc_SipMessage *msg,
+                                               const char *name) {
+  if (!msg || !name) {
+    return NULL;
+  }
+
+  struct cmsc_String header_name = {.buf = name, .len = strlen(name)};
+  uint16_t id = cmsc_registry_find_id(header_name);
+
+#if CMSC_WITH_HEADERS_INDEX
+  // List is walked only if index cannot be allocated
+  if (msg->_headers_index || cmsc_sipmsg_index_create(msg)) {
+    return cmsc_sipmsg_index_lookup(id, header_name, msg)->first;
+  }
+#endif
+
+  struct cmsc_SipHeader *header;
+  STAILQ_FOREACH(header, &msg->sip_headers, _next) {
+    if (cmsc_sipmsg_is_header_named(header, id, header_name, msg)) {
+      return header;
+    }
+  }
+
+  return NULL;
+}
+
+struct cmsc_SipHeader *
+cmsc_sipmsg_next_header(struct cmsc_SipMessage *msg,
+                        const struct cmsc_SipHeader *header) {
+  if (!msg || !header) {
+    return NULL;
+  }
+
+#if CMSC_WITH_HEADERS_INDEX
+  if (msg->_headers_index) {
+    return header->_next_same;
+  }
+#endif
+
+  struct cmsc_String header_name = cmsc_bs_msg_to_string(&header->key, msg);
+  struct cmsc_SipHeader *next = STAILQ_NEXT(header, _next);
+  for (; next; next = STAILQ_NEXT(next, _next)) {
+    if (cmsc_sipmsg_is_header_named(next, header->id, header_name, msg)) {
+      return next;
+    }
+  }
+
+  return NULL;
+}
+
 cme_error_t cmsc_sipmsg_insert_body(const uint32_t body_len, const char *body,
                                     struct cmsc_SipMessage *msg) {
   cme_error_t err;
@@ -228,8 +420,8 @@ cme_error_t cmsc_sipmsg_insert_body(const uint32_t body_len, const char *body,
     return 0;
   }
 
-  err = cmsc_buffer_binsert((struct cmsc_String){.buf = body, .len = body_len},
-                            &msg->_buf, &msg->body);
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = body, .len = body_len},
+                            msg, &msg->body);
   if (err) {
     goto error_out;
   }
@@ -257,15 +449,15 @@ cme_error_t cmsc_sipmsg_insert_to(uint32_t uri_len, const char *uri,
     return 0;
   }
 
-  err = cmsc_buffer_binsert((struct cmsc_String){.buf = uri, .len = uri_len},
-                            &msg->_buf, &msg->to.uri);
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = uri, .len = uri_len},
+                            msg, &msg->to.uri);
   if (err) {
     goto error_out;
   }
 
   if (tag && tag_len > 0) {
-    err = cmsc_buffer_binsert((struct cmsc_String){.buf = tag, .len = tag_len},
-                              &msg->_buf, &msg->to.tag);
+    err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = tag, .len = tag_len},
+                              msg, &msg->to.tag);
     if (err) {
       goto error_out;
     }
@@ -293,15 +485,15 @@ cme_error_t cmsc_sipmsg_insert_from(uint32_t uri_len, const char *uri,
     return 0;
   }
 
-  err = cmsc_buffer_binsert((struct cmsc_String){.buf = uri, .len = uri_len},
-                            &msg->_buf, &msg->from.uri);
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = uri, .len = uri_len},
+                            msg, &msg->from.uri);
   if (err) {
     goto error_out;
   }
 
   if (tag && tag_len > 0) {
-    err = cmsc_buffer_binsert((struct cmsc_String){.buf = tag, .len = tag_len},
-                              &msg->_buf, &msg->from.tag);
+    err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = tag, .len = tag_len},
+                              msg, &msg->from.tag);
     if (err) {
       goto error_out;
     }
@@ -329,8 +521,8 @@ cme_error_t cmsc_sipmsg_insert_call_id(uint32_t call_id_len,
     return 0;
   }
 
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = call_id, .len = call_id_len}, &msg->_buf,
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = call_id, .len = call_id_len}, msg,
       &msg->call_id);
   if (err) {
     goto error_out;
@@ -359,9 +551,9 @@ cme_error_t cmsc_sipmsg_insert_cseq(uint32_t sip_method_len,
     return 0;
   }
 
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.buf = sip_method, .len = sip_method_len},
-      &msg->_buf, &msg->cseq.method);
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = sip_method, .len = sip_method_len}, msg,
+      &msg->cseq.method);
   if (err) {
     goto error_out;
   }
@@ -395,6 +587,32 @@ error_out:
   return cme_return(err);
 }
 
+cme_error_t cmsc_sipmsg_decrement_max_forwards(struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!msg) {
+    err = cme_error(EINVAL, "`msg` cannot be NULL");
+    goto error_out;
+  }
+
+  if (!cmsc_sipmsg_is_field_present(msg,
+                                    cmsc_SupportedSipHeaders_MAX_FORWARDS)) {
+    msg->max_forwards = 70;
+  } else if (msg->max_forwards == 0) {
+    err = cme_error(ELOOP, "Max-Forwards reached zero");
+    goto error_out;
+  } else {
+    msg->max_forwards--;
+  }
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_MAX_FORWARDS);
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
 cme_error_t cmsc_sipmsg_insert_content_length(uint32_t content_length,
                                               struct cmsc_SipMessage *msg) {
   cme_error_t err;
@@ -414,12 +632,221 @@ error_out:
   return cme_return(err);
 }
 
-cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
-                                   uint32_t sent_by_len, const char *sent_by,
-                                   uint32_t addr_len, const char *addr,
-                                   uint32_t branch_len, const char *branch,
-                                   uint32_t received_len, const char *received,
-                                   uint32_t ttl, struct cmsc_SipMessage *msg) {
+#if CMSC_WITH_CONTENT_TYPE
+cme_error_t cmsc_sipmsg_insert_content_type(uint32_t type_len, const char *type,
+                                            uint32_t params_len,
+                                            const char *params,
+                                            struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!type || !msg) {
+    err = cme_error(EINVAL, "`type` and `msg` cannot be NULL");
+    goto error_out;
+  }
+
+  if (type_len == 0) {
+    return 0;
+  }
+
+  memset(&msg->content_type, 0, sizeof(struct cmsc_SipHeaderContentType));
+
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = type, .len = type_len},
+                            msg, &msg->content_type.type);
+  if (err) {
+    goto error_out;
+  }
+
+  if (params && params_len > 0) {
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.buf = params, .len = params_len}, msg,
+        &msg->content_type.params);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  cmsc_decode_content_type(&msg->content_type, msg);
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_CONTENT_TYPE);
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_EVENT
+cme_error_t cmsc_sipmsg_insert_event(uint32_t package_len, const char *package,
+                                     uint32_t params_len, const char *params,
+                                     struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!package || !msg) {
+    err = cme_error(EINVAL, "`package` and `msg` cannot be NULL");
+    goto error_out;
+  }
+
+  if (package_len == 0) {
+    return 0;
+  }
+
+  memset(&msg->event, 0, sizeof(struct cmsc_SipHeaderEvent));
+
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = package, .len = package_len}, msg,
+      &msg->event.package);
+  if (err) {
+    goto error_out;
+  }
+
+  if (params && params_len > 0) {
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.buf = params, .len = params_len}, msg,
+        &msg->event.params);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  cmsc_decode_event(&msg->event, msg);
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_EVENT);
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_SUBSCRIPTION_STATE
+cme_error_t cmsc_sipmsg_insert_subscription_state(uint32_t state_len,
+                                                  const char *state,
+                                                  uint32_t params_len,
+                                                  const char *params,
+                                                  struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!state || !msg) {
+    err = cme_error(EINVAL, "`state` and `msg` cannot be NULL");
+    goto error_out;
+  }
+
+  if (state_len == 0) {
+    return 0;
+  }
+
+  memset(&msg->subscription_state, 0,
+         sizeof(struct cmsc_SipHeaderSubscriptionState));
+
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = state, .len = state_len}, msg,
+      &msg->subscription_state.state_name);
+  if (err) {
+    goto error_out;
+  }
+
+  if (params && params_len > 0) {
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.buf = params, .len = params_len}, msg,
+        &msg->subscription_state.params);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  cmsc_decode_subscription_state(&msg->subscription_state, msg);
+  cmsc_sipmsg_mark_field_present(msg,
+                                 cmsc_SupportedSipHeaders_SUBSCRIPTION_STATE);
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_EXPIRES
+cme_error_t cmsc_sipmsg_insert_expires(uint32_t expires,
+                                       struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!msg) {
+    err = cme_error(EINVAL, "`msg` cannot be NULL");
+    goto error_out;
+  }
+
+  msg->expires = expires;
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_EXPIRES);
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+#if CMSC_WITH_MIN_EXPIRES
+cme_error_t cmsc_sipmsg_insert_min_expires(uint32_t min_expires,
+                                           struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!msg) {
+    err = cme_error(EINVAL, "`msg` cannot be NULL");
+    goto error_out;
+  }
+
+  msg->min_expires = min_expires;
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_MIN_EXPIRES);
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+cme_error_t cmsc_sipmsg_insert_extension(uint32_t slot, void *data,
+                                         struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!msg) {
+    err = cme_error(EINVAL, "`msg` cannot be NULL");
+    goto error_out;
+  }
+
+  const struct cmsc_HeaderCodec *codec = cmsc_registry_get_codec(slot);
+  if (!codec) {
+    err = cme_errorf(EINVAL, "Slot %u is not registered", slot);
+    goto error_out;
+  }
+
+  // Previous value is replaced, so it has to be released first
+  if ((msg->extensions_mask & (1u << slot)) && codec->destroy_func) {
+    codec->destroy_func(&msg->extensions[slot]);
+  }
+
+  msg->extensions[slot] = (struct cmsc_SipHeaderExtension){.data = data};
+  msg->extensions_mask |= 1u << slot;
+#if CMSC_WITH_PASS_THROUGH
+  // Extensions have no dirty bits, so parsed lines cannot be reused
+  msg->_is_lines_invalid = true;
+#endif
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t
+cmsc_sipmsg_add_via(uint32_t proto_len, const char *proto, uint32_t sent_by_len,
+                    const char *sent_by, uint32_t addr_len, const char *addr,
+                    uint32_t branch_len, const char *branch,
+                    uint32_t received_len, const char *received, uint32_t ttl,
+                    bool has_rport, bool is_head,
+                    struct cmsc_SipMessage *msg) {
   cme_error_t err;
 
   if (!msg || !proto || !sent_by) {
@@ -439,14 +866,14 @@ cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
   }
 
   err =
-      cmsc_buffer_binsert((struct cmsc_String){.len = proto_len, .buf = proto},
-                          &msg->_buf, &via->proto);
+      cmsc_sipmsg_binsert((struct cmsc_String){.len = proto_len, .buf = proto},
+                          msg, &via->proto);
   if (err) {
     goto error_via_cleanup;
   }
 
-  err = cmsc_buffer_binsert(
-      (struct cmsc_String){.len = sent_by_len, .buf = sent_by}, &msg->_buf,
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.len = sent_by_len, .buf = sent_by}, msg,
       &via->sent_by);
   if (err) {
     goto error_via_cleanup;
@@ -454,16 +881,16 @@ cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
 
   if (addr_len && addr) {
     err =
-        cmsc_buffer_binsert((struct cmsc_String){.len = addr_len, .buf = addr},
-                            &msg->_buf, &via->addr);
+        cmsc_sipmsg_binsert((struct cmsc_String){.len = addr_len, .buf = addr},
+                            msg, &via->addr);
     if (err) {
       goto error_via_cleanup;
     }
   }
 
   if (branch_len && branch) {
-    err = cmsc_buffer_binsert(
-        (struct cmsc_String){.len = branch_len, .buf = branch}, &msg->_buf,
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.len = branch_len, .buf = branch}, msg,
         &via->branch);
     if (err) {
       goto error_via_cleanup;
@@ -471,8 +898,8 @@ cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
   }
 
   if (received_len && received) {
-    err = cmsc_buffer_binsert(
-        (struct cmsc_String){.len = received_len, .buf = received}, &msg->_buf,
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.len = received_len, .buf = received}, msg,
         &via->received);
     if (err) {
       goto error_via_cleanup;
@@ -480,8 +907,13 @@ cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
   }
 
   via->ttl = ttl;
+  via->has_rport = has_rport;
 
-  STAILQ_INSERT_TAIL(&msg->vias, via, _next);
+  if (is_head) {
+    STAILQ_INSERT_HEAD(&msg->vias, via, _next);
+  } else {
+    STAILQ_INSERT_TAIL(&msg->vias, via, _next);
+  }
   cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_VIAS);
 
   return 0;
@@ -491,3 +923,592 @@ error_via_cleanup:
 error_out:
   return cme_return(err);
 }
+
+cme_error_t cmsc_sipmsg_insert_via(uint32_t proto_len, const char *proto,
+                                   uint32_t sent_by_len, const char *sent_by,
+                                   uint32_t addr_len, const char *addr,
+                                   uint32_t branch_len, const char *branch,
+                                   uint32_t received_len, const char *received,
+                                   uint32_t ttl, bool has_rport,
+                                   struct cmsc_SipMessage *msg) {
+  return cmsc_sipmsg_add_via(proto_len, proto, sent_by_len, sent_by, addr_len,
+                             addr, branch_len, branch, received_len, received,
+                             ttl, has_rport, false, msg);
+}
+
+cme_error_t cmsc_sipmsg_prepend_via(uint32_t proto_len, const char *proto,
+                                    uint32_t sent_by_len, const char *sent_by,
+                                    uint32_t addr_len, const char *addr,
+                                    uint32_t branch_len, const char *branch,
+                                    uint32_t received_len, const char *received,
+                                    uint32_t ttl, bool has_rport,
+                                    struct cmsc_SipMessage *msg) {
+  return cmsc_sipmsg_add_via(proto_len, proto, sent_by_len, sent_by, addr_len,
+                             addr, branch_len, branch, received_len, received,
+                             ttl, has_rport, true, msg);
+}
+
+cme_error_t cmsc_sipmsg_pop_via(struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!msg) {
+    err = cme_error(EINVAL, "`msg` cannot be NULL");
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderVia *via = STAILQ_FIRST(&msg->vias);
+  if (!via) {
+    err = cme_error(ENOENT, "There is no via to pop");
+    goto error_out;
+  }
+
+  STAILQ_REMOVE_HEAD(&msg->vias, _next);
+  free(via);
+
+  cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_VIAS);
+  if (STAILQ_EMPTY(&msg->vias)) {
+    msg->presence_mask &= ~cmsc_SupportedSipHeaders_VIAS;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_ROUTE || CMSC_WITH_RECORD_ROUTE
+static cme_error_t cmsc_sipmsg_add_route(uint32_t uri_len, const char *uri,
+                                         uint32_t params_len,
+                                         const char *params, bool is_head,
+                                         struct cmsc_SipRoutesList *routes,
+                                         enum cmsc_SupportedSipHeaders field,
+                                         struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  if (!uri || !uri_len) {
+    err = cme_error(EINVAL, "`uri` cannot be NULL or empty");
+    goto error_out;
+  }
+
+  struct cmsc_SipHeaderRoute *route =
+      calloc(1, sizeof(struct cmsc_SipHeaderRoute));
+  if (!route) {
+    err = cme_error(ENOMEM, "Cannot allocate memory for `route`");
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = uri, .len = uri_len},
+                            msg, &route->uri);
+  if (err) {
+    goto error_route_cleanup;
+  }
+
+  if (params && params_len > 0) {
+    err = cmsc_sipmsg_binsert(
+        (struct cmsc_String){.buf = params, .len = params_len}, msg,
+        &route->params);
+    if (err) {
+      goto error_route_cleanup;
+    }
+  }
+
+  if (is_head) {
+    STAILQ_INSERT_HEAD(routes, route, _next);
+  } else {
+    STAILQ_INSERT_TAIL(routes, route, _next);
+  }
+  cmsc_sipmsg_mark_field_present(msg, field);
+
+  return 0;
+
+error_route_cleanup:
+  free(route);
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmsc_sipmsg_pop_route_of(struct cmsc_SipRoutesList *routes,
+                                            enum cmsc_SupportedSipHeaders field,
+                                            struct cmsc_SipMessage *msg) {
+  struct cmsc_SipHeaderRoute *route = STAILQ_FIRST(routes);
+  if (!route) {
+    return cme_error(ENOENT, "There is no route to pop");
+  }
+
+  STAILQ_REMOVE_HEAD(routes, _next);
+  free(route);
+
+  cmsc_sipmsg_mark_field_present(msg, field);
+  if (STAILQ_EMPTY(routes)) {
+    msg->presence_mask &= ~field;
+  }
+
+  return 0;
+}
+#endif
+
+#if CMSC_WITH_ROUTE
+cme_error_t cmsc_sipmsg_insert_route(uint32_t uri_len, const char *uri,
+                                     uint32_t params_len, const char *params,
+                                     struct cmsc_SipMessage *msg) {
+  if (!msg) {
+    return cme_error(EINVAL, "`msg` cannot be NULL");
+  }
+
+  return cmsc_sipmsg_add_route(uri_len, uri, params_len, params, false,
+                               &msg->routes, cmsc_SupportedSipHeaders_ROUTE,
+                               msg);
+}
+
+cme_error_t cmsc_sipmsg_prepend_route(uint32_t uri_len, const char *uri,
+                                      uint32_t params_len, const char *params,
+                                      struct cmsc_SipMessage *msg) {
+  if (!msg) {
+    return cme_error(EINVAL, "`msg` cannot be NULL");
+  }
+
+  return cmsc_sipmsg_add_route(uri_len, uri, params_len, params, true,
+                               &msg->routes, cmsc_SupportedSipHeaders_ROUTE,
+                               msg);
+}
+
+cme_error_t cmsc_sipmsg_pop_route(struct cmsc_SipMessage *msg) {
+  if (!msg) {
+    return cme_error(EINVAL, "`msg` cannot be NULL");
+  }
+
+  return cmsc_sipmsg_pop_route_of(&msg->routes, cmsc_SupportedSipHeaders_ROUTE,
+                                  msg);
+}
+#endif
+
+#if CMSC_WITH_RECORD_ROUTE
+cme_error_t cmsc_sipmsg_insert_record_route(uint32_t uri_len, const char *uri,
+                                            uint32_t params_len,
+                                            const char *params,
+                                            struct cmsc_SipMessage *msg) {
+  if (!msg) {
+    return cme_error(EINVAL, "`msg` cannot be NULL");
+  }
+
+  return cmsc_sipmsg_add_route(uri_len, uri, params_len, params, false,
+                               &msg->record_routes,
+                               cmsc_SupportedSipHeaders_RECORD_ROUTE, msg);
+}
+
+cme_error_t cmsc_sipmsg_prepend_record_route(uint32_t uri_len, const char *uri,
+                                             uint32_t params_len,
+                                             const char *params,
+                                             struct cmsc_SipMessage *msg) {
+  if (!msg) {
+    return cme_error(EINVAL, "`msg` cannot be NULL");
+  }
+
+  return cmsc_sipmsg_add_route(uri_len, uri, params_len, params, true,
+                               &msg->record_routes,
+                               cmsc_SupportedSipHeaders_RECORD_ROUTE, msg);
+}
+
+cme_error_t cmsc_sipmsg_pop_record_route(struct cmsc_SipMessage *msg) {
+  if (!msg) {
+    return cme_error(EINVAL, "`msg` cannot be NULL");
+  }
+
+  return cmsc_sipmsg_pop_route_of(&msg->record_routes,
+                                  cmsc_SupportedSipHeaders_RECORD_ROUTE, msg);
+}
+#endif
+
+/* Body is the only part of `src` buffer derived messages never need, it is
+   left out if it ends the buffer. Other fields lie before it then. */
+static uint32_t cmsc_sipmsg_shared_len(const struct cmsc_SipMessage *src) {
+  if (src->body.len && src->body.buf_offset + src->body.len == src->_buf.len) {
+    return src->body.buf_offset;
+  }
+
+  return src->_buf.len;
+}
+
+/* Requests derived from requests keep only top via, its parsed line is shared
+   only if there are no other vias. */
+static cme_error_t cmsc_sipmsg_copy_vias(const struct cmsc_SipMessage *src,
+                                         bool is_top_only,
+                                         struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  struct cmsc_SipHeaderVia *via;
+  STAILQ_FOREACH(via, &src->vias, _next) {
+    if (is_top_only && via != STAILQ_FIRST(&src->vias)) {
+      cmsc_sipmsg_mark_field_dirty(msg, cmsc_SupportedSipHeaders_VIAS);
+      break;
+    }
+
+    struct cmsc_SipHeaderVia *via_cp = malloc(sizeof(struct cmsc_SipHeaderVia));
+    if (!via_cp) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `via_cp`");
+      goto error_out;
+    }
+
+    *via_cp = *via;
+    STAILQ_INSERT_TAIL(&msg->vias, via_cp, _next);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#if CMSC_WITH_ROUTE
+static cme_error_t
+cmsc_sipmsg_copy_routes(const struct cmsc_SipRoutesList *src_routes,
+                        struct cmsc_SipRoutesList *routes) {
+  cme_error_t err;
+
+  struct cmsc_SipHeaderRoute *route;
+  STAILQ_FOREACH(route, src_routes, _next) {
+    struct cmsc_SipHeaderRoute *route_cp =
+        malloc(sizeof(struct cmsc_SipHeaderRoute));
+    if (!route_cp) {
+      err = cme_error(ENOMEM, "Cannot allocate memory for `route_cp`");
+      goto error_out;
+    }
+
+    *route_cp = *route;
+    STAILQ_INSERT_TAIL(routes, route_cp, _next);
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+/* Creates message with `fields` of `src`. Buffer of `src` is copied at once so
+   fields keep their offsets, parsed lines of `src` first line and of `fields`
+   are kept too. First line has to be inserted by caller. Message owns its
+   buffer like one created by cmsc_sipmsg_create_with_buf. */
+static cme_error_t cmsc_sipmsg_derive(const struct cmsc_SipMessage *src,
+                                      uint32_t fields, bool is_top_via_only,
+                                      struct cmsc_SipMessage **msg) {
+  cme_error_t err;
+
+  uint32_t len = cmsc_sipmsg_shared_len(src);
+  struct cmsc_Buffer buf = {.len = len,
+                            .size = len + CMSC_SIPMSG_DEFAULT_BUF_SIZE};
+  buf.buf = malloc(buf.size);
+  if (!buf.buf) {
+    err = cme_error(ENOMEM, "Cannot allocate memory for `buf.buf`");
+    goto error_out;
+  }
+  memcpy((void *)buf.buf, src->_buf.buf, len);
+
+  err = cmsc_sipmsg_create(buf, msg);
+  if (err) {
+    goto error_buf_cleanup;
+  }
+
+  struct cmsc_SipMessage *local_msg = *msg;
+  fields &= src->presence_mask;
+  local_msg->presence_mask = fields;
+  // Fields modified after parsing have stale lines, so they are encoded again
+  local_msg->dirty_mask = fields & src->dirty_mask;
+#if CMSC_WITH_PASS_THROUGH
+  local_msg->is_pass_through = src->is_pass_through;
+#endif
+
+  if (fields & cmsc_SupportedSipHeaders_VIAS) {
+    err = cmsc_sipmsg_copy_vias(src, is_top_via_only, local_msg);
+    if (err) {
+      goto error_msg_cleanup;
+    }
+  }
+  if (fields & cmsc_SupportedSipHeaders_FROM) {
+    local_msg->from = src->from;
+  }
+  if (fields & cmsc_SupportedSipHeaders_TO) {
+    local_msg->to = src->to;
+  }
+  if (fields & cmsc_SupportedSipHeaders_CALL_ID) {
+    local_msg->call_id = src->call_id;
+  }
+  if (fields & cmsc_SupportedSipHeaders_CSEQ) {
+    local_msg->cseq = src->cseq;
+  }
+  if (fields & cmsc_SupportedSipHeaders_MAX_FORWARDS) {
+    local_msg->max_forwards = src->max_forwards;
+  }
+#if CMSC_WITH_ROUTE
+  if (fields & cmsc_SupportedSipHeaders_ROUTE) {
+    err = cmsc_sipmsg_copy_routes(&src->routes, &local_msg->routes);
+    if (err) {
+      goto error_msg_cleanup;
+    }
+  }
+#endif
+
+#if CMSC_WITH_PASS_THROUGH
+  if (src->_lines_len && !src->_is_lines_invalid) {
+    err = cmsc_sipmsg_create_lines(src->_lines_len, local_msg);
+    if (err) {
+      goto error_msg_cleanup;
+    }
+
+    for (uint32_t i = 0; i < src->_lines_len; i++) {
+      if (i == 0 || (src->_lines[i].field & fields)) {
+        local_msg->_lines[local_msg->_lines_len++] = src->_lines[i];
+      }
+    }
+  }
+#endif
+
+  return 0;
+
+error_msg_cleanup:
+  cmsc_sipmsg_destroy_with_buf(msg);
+  return cme_return(err);
+error_buf_cleanup:
+  free((void *)buf.buf);
+error_out:
+  return cme_return(err);
+}
+
+/* Shared To line is replaced by its copy with the tag appended, built at the
+   end of `msg` buffer, so To is still not encoded again. */
+static cme_error_t cmsc_sipmsg_append_to_tag(const struct cmsc_SipMessage *src,
+                                             uint32_t tag_len, const char *tag,
+                                             struct cmsc_SipMessage *msg) {
+  struct cmsc_SipLine *line = NULL;
+  cme_error_t err;
+
+#if CMSC_WITH_PASS_THROUGH
+  for (uint32_t i = 0; i < msg->_lines_len; i++) {
+    if (msg->_lines[i].field == cmsc_SupportedSipHeaders_TO) {
+      line = &msg->_lines[i];
+      break;
+    }
+  }
+#endif
+
+  if (!line || (msg->dirty_mask & cmsc_SupportedSipHeaders_TO)) {
+    err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = tag, .len = tag_len},
+                              msg, &msg->to.tag);
+    if (err) {
+      goto error_out;
+    }
+
+    cmsc_sipmsg_mark_field_present(msg, cmsc_SupportedSipHeaders_TO);
+    return 0;
+  }
+
+  // Line is taken from `src` as `msg` buffer may move while it grows
+  struct cmsc_BString to_line;
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = src->_buf.buf + line->offset,
+                           .len = line->len - 2},
+      msg, &to_line);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_binsert(CMSC_BUFFER_LITERAL(";tag="), msg, NULL);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_binsert((struct cmsc_String){.buf = tag, .len = tag_len},
+                            msg, &msg->to.tag);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_binsert(CMSC_BUFFER_LITERAL("\r\n"), msg, NULL);
+  if (err) {
+    goto error_out;
+  }
+
+  line->offset = to_line.buf_offset;
+  line->len = msg->_buf.len - to_line.buf_offset;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_make_response(const struct cmsc_SipMessage *req,
+                               uint32_t status_code, uint32_t reason_phrase_len,
+                               const char *reason_phrase, uint32_t to_tag_len,
+                               const char *to_tag,
+                               struct cmsc_SipMessage **resp) {
+  cme_error_t err;
+
+  if (!req || !reason_phrase || !resp) {
+    err = cme_error(EINVAL, "`req`, `reason_phrase` and `resp` cannot be NULL");
+    goto error_out;
+  }
+
+  if (status_code < 100 || status_code > 699) {
+    err = cme_errorf(EINVAL, "Invalid status code %u", status_code);
+    goto error_out;
+  }
+
+  if (!(req->presence_mask & cmsc_SupportedSipHeaders_REQUEST_LINE)) {
+    err = cme_error(EINVAL, "`req` has to be a request");
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_derive(
+      req,
+      cmsc_SupportedSipHeaders_VIAS | cmsc_SupportedSipHeaders_FROM |
+          cmsc_SupportedSipHeaders_TO | cmsc_SupportedSipHeaders_CALL_ID |
+          cmsc_SupportedSipHeaders_CSEQ,
+      false, resp);
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_SipMessage *local_resp = *resp;
+
+  local_resp->status_line.sip_proto_ver = req->request_line.sip_proto_ver;
+  local_resp->status_line.status_code = status_code;
+  err = cmsc_sipmsg_binsert(
+      (struct cmsc_String){.buf = reason_phrase, .len = reason_phrase_len},
+      local_resp, &local_resp->status_line.reason_phrase);
+  if (err) {
+    goto error_resp_cleanup;
+  }
+  cmsc_sipmsg_mark_field_present(local_resp,
+                                 cmsc_SupportedSipHeaders_STATUS_LINE);
+
+  if (to_tag && to_tag_len && !local_resp->to.tag.len) {
+    err = cmsc_sipmsg_append_to_tag(req, to_tag_len, to_tag, local_resp);
+    if (err) {
+      goto error_resp_cleanup;
+    }
+  }
+
+  local_resp->content_length = 0;
+  cmsc_sipmsg_mark_field_present(local_resp,
+                                 cmsc_SupportedSipHeaders_CONTENT_LENGTH);
+
+  return 0;
+
+error_resp_cleanup:
+  cmsc_sipmsg_destroy_with_buf(resp);
+error_out:
+  return cme_return(err);
+}
+
+/* Request sharing Request-URI, top Via, From, To, Call-ID, CSeq number, Route
+   and Max-Forwards with `req`, RFC 3261 9.1 and 17.1.1.3. New method is stored
+   once and used by both request line and CSeq. */
+static cme_error_t cmsc_sipmsg_derive_request(const struct cmsc_SipMessage *req,
+                                              const struct cmsc_String method,
+                                              struct cmsc_SipMessage **msg) {
+  cme_error_t err;
+
+  if (!(req->presence_mask & cmsc_SupportedSipHeaders_REQUEST_LINE) ||
+      !(req->presence_mask & cmsc_SupportedSipHeaders_CSEQ)) {
+    err = cme_error(EINVAL, "`req` has to be a request with CSeq");
+    goto error_out;
+  }
+
+  uint32_t fields =
+      cmsc_SupportedSipHeaders_VIAS | cmsc_SupportedSipHeaders_FROM |
+      cmsc_SupportedSipHeaders_TO | cmsc_SupportedSipHeaders_CALL_ID |
+      cmsc_SupportedSipHeaders_CSEQ | cmsc_SupportedSipHeaders_MAX_FORWARDS;
+#if CMSC_WITH_ROUTE
+  fields |= cmsc_SupportedSipHeaders_ROUTE;
+#endif
+
+  err = cmsc_sipmsg_derive(req, fields, true, msg);
+  if (err) {
+    goto error_out;
+  }
+
+  struct cmsc_SipMessage *local_msg = *msg;
+
+  err = cmsc_sipmsg_binsert(method, local_msg, &local_msg->cseq.method);
+  if (err) {
+    goto error_msg_cleanup;
+  }
+  cmsc_sipmsg_mark_field_present(local_msg, cmsc_SupportedSipHeaders_CSEQ);
+
+  local_msg->request_line = req->request_line;
+  local_msg->request_line.sip_method = local_msg->cseq.method;
+  cmsc_sipmsg_mark_field_present(local_msg,
+                                 cmsc_SupportedSipHeaders_REQUEST_LINE);
+
+  local_msg->content_length = 0;
+  cmsc_sipmsg_mark_field_present(local_msg,
+                                 cmsc_SupportedSipHeaders_CONTENT_LENGTH);
+
+  return 0;
+
+error_msg_cleanup:
+  cmsc_sipmsg_destroy_with_buf(msg);
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_make_cancel(const struct cmsc_SipMessage *req,
+                             struct cmsc_SipMessage **cancel) {
+  cme_error_t err;
+
+  if (!req || !cancel) {
+    err = cme_error(EINVAL, "`req` and `cancel` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_derive_request(req, CMSC_BUFFER_LITERAL("CANCEL"), cancel);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_make_ack(const struct cmsc_SipMessage *invite,
+                          const struct cmsc_SipMessage *resp,
+                          struct cmsc_SipMessage **ack) {
+  cme_error_t err;
+
+  if (!invite || !resp || !ack) {
+    err = cme_error(EINVAL, "`invite`, `resp` and `ack` cannot be NULL");
+    goto error_out;
+  }
+
+  // ACK of 2xx is a new transaction, it is built by dialog
+  if (!(resp->presence_mask & cmsc_SupportedSipHeaders_STATUS_LINE) ||
+      resp->status_line.status_code < 300) {
+    err = cme_error(EINVAL, "`resp` has to be non-2xx final response");
+    goto error_out;
+  }
+
+  err = cmsc_sipmsg_derive_request(invite, CMSC_BUFFER_LITERAL("ACK"), ack);
+  if (err) {
+    goto error_out;
+  }
+
+  // To of ACK equals To of response, which differs only by tag
+  if (resp->to.tag.len && !(*ack)->to.tag.len) {
+    err = cmsc_sipmsg_append_to_tag(invite, resp->to.tag.len,
+                                    resp->_buf.buf + resp->to.tag.buf_offset,
+                                    *ack);
+    if (err) {
+      goto error_ack_cleanup;
+    }
+  }
+
+  return 0;
+
+error_ack_cleanup:
+  cmsc_sipmsg_destroy_with_buf(ack);
+error_out:
+  return cme_return(err);
+}
@@ -13,6 +13,7 @@
 
 #include "c_minilib_error.h"
 #include "c_minilib_sip_codec.h"
+#include "utils/bstring.h"
 
 #ifndef CMSC_SIPMSG_DEFAULT_BUF_SIZE
 #define CMSC_SIPMSG_DEFAULT_BUF_SIZE 512
@@ -37,6 +38,39 @@ static inline cme_error_t cmsc_sipmsg_create(struct cmsc_Buffer buf,
 
   STAILQ_INIT(&local_msg->sip_headers);
   STAILQ_INIT(&local_msg->vias);
+#if CMSC_WITH_ROUTE
+  STAILQ_INIT(&local_msg->routes);
+#endif
+#if CMSC_WITH_RECORD_ROUTE
+  STAILQ_INIT(&local_msg->record_routes);
+#endif
+#if CMSC_WITH_ALLOW
+  STAILQ_INIT(&local_msg->allow.unknown);
+#endif
+#if CMSC_WITH_SUPPORTED
+  STAILQ_INIT(&local_msg->supported.unknown);
+#endif
+#if CMSC_WITH_REQUIRE
+  STAILQ_INIT(&local_msg->require.unknown);
+#endif
+#if CMSC_WITH_PROXY_REQUIRE
+  STAILQ_INIT(&local_msg->proxy_require.unknown);
+#endif
+#if CMSC_WITH_UNSUPPORTED
+  STAILQ_INIT(&local_msg->unsupported.unknown);
+#endif
+#if CMSC_WITH_P_ASSERTED_IDENTITY
+  STAILQ_INIT(&local_msg->p_asserted_identities);
+#endif
+#if CMSC_WITH_P_PREFERRED_IDENTITY
+  STAILQ_INIT(&local_msg->p_preferred_identities);
+#endif
+#if CMSC_WITH_DIVERSION
+  STAILQ_INIT(&local_msg->diversions);
+#endif
+#if CMSC_WITH_HISTORY_INFO
+  STAILQ_INIT(&local_msg->history_infos);
+#endif
 
   local_msg->_buf = buf;
   *msg = local_msg;
@@ -51,6 +85,155 @@ static inline void
 cmsc_sipmsg_mark_field_present(struct cmsc_SipMessage *msg,
                                enum cmsc_SupportedSipHeaders header_id) {
   msg->presence_mask = msg->presence_mask | header_id;
+  msg->dirty_mask = msg->dirty_mask | header_id;
+}
+
+#if CMSC_WITH_PASS_THROUGH
+// Allocates table for `lines_size` lines, it is released with `msg`.
+static inline cme_error_t cmsc_sipmsg_create_lines(uint32_t lines_size,
+                                                   struct cmsc_SipMessage *msg) {
+  cme_error_t err;
+
+  msg->_lines = malloc(lines_size * sizeof(struct cmsc_SipLine));
+  if (!msg->_lines) {
+    err = cme_error(ENOMEM, "Cannot allocate memory for `msg->_lines`");
+    goto error_out;
+  }
+  msg->_lines_size = lines_size;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+#endif
+
+// Line spans `[offset, end)` of `_buf`, `end` includes CRLF.
+static inline void cmsc_sipmsg_record_line(uint32_t offset, uint32_t end,
+                                           uint32_t field,
+                                           struct cmsc_SipMessage *msg) {
+#if CMSC_WITH_PASS_THROUGH
+  if (msg->_lines_len >= msg->_lines_size) {
+    msg->_is_lines_invalid = true;
+    return;
+  }
+
+  msg->_lines[msg->_lines_len++] = (struct cmsc_SipLine){
+      .offset = offset, .len = end - offset, .field = field};
+#else
+  (void)offset;
+  (void)end;
+  (void)field;
+  (void)msg;
+#endif
+}
+
+/* Compact and full names are equivalent, RFC 3261 7.3.3, so headers with
+   known names are matched by `id`. Only unknown names are compared. */
+static inline bool
+cmsc_sipmsg_is_header_named(const struct cmsc_SipHeader *header, uint16_t id,
+                            const struct cmsc_String name,
+                            struct cmsc_SipMessage *msg) {
+  if (id != cmsc_HeaderNames_UNKNOWN) {
+    return header->id == id;
+  }
+
+  return header->id == cmsc_HeaderNames_UNKNOWN &&
+         header->key.len == name.len &&
+         strncasecmp(cmsc_bs_msg_to_string(&header->key, msg).buf, name.buf,
+                     name.len) == 0;
+}
+
+#if CMSC_WITH_HEADERS_INDEX
+static inline uint32_t cmsc_sipmsg_header_hash(uint16_t id,
+                                               const struct cmsc_String name) {
+  // Knuth multiplicative hash spreads consecutive ids over the index
+  return id != cmsc_HeaderNames_UNKNOWN ? id * 2654435761u
+                                        : cmsc_s_hash_nocase(name);
 }
 
+// Returns slot holding `id` or `name` or empty slot where it belongs.
+static inline struct cmsc_SipHeadersIndexSlot *
+cmsc_sipmsg_index_lookup(uint16_t id, const struct cmsc_String name,
+                         struct cmsc_SipMessage *msg) {
+  uint32_t hash = cmsc_sipmsg_header_hash(id, name);
+  uint32_t mask = msg->_headers_index_size - 1;
+  uint32_t i = hash & mask;
+  while (msg->_headers_index[i].first) {
+    if (msg->_headers_index[i].hash == hash &&
+        cmsc_sipmsg_is_header_named(msg->_headers_index[i].first, id, name,
+                                    msg)) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+
+  return &msg->_headers_index[i];
+}
+
+/* Chains `header` after last header with the same name. Header has to be
+   already appended to `msg->sip_headers`. Returns false if index has no room
+   for new name. */
+static inline bool cmsc_sipmsg_index_header(struct cmsc_SipHeader *header,
+                                            struct cmsc_SipMessage *msg) {
+  struct cmsc_String name = cmsc_bs_msg_to_string(&header->key, msg);
+  struct cmsc_SipHeadersIndexSlot *slot =
+      cmsc_sipmsg_index_lookup(header->id, name, msg);
+
+  header->_next_same = NULL;
+  if (slot->first) {
+    slot->last->_next_same = header;
+    slot->last = header;
+    return true;
+  }
+
+  if (msg->_headers_index_len >= msg->_headers_index_size / 2) {
+    return false;
+  }
+
+  *slot = (struct cmsc_SipHeadersIndexSlot){
+      .hash = cmsc_sipmsg_header_hash(header->id, name),
+      .first = header,
+      .last = header};
+  msg->_headers_index_len++;
+
+  return true;
+}
+
+// Index is built again on next lookup.
+static inline void cmsc_sipmsg_index_destroy(struct cmsc_SipMessage *msg) {
+  free(msg->_headers_index);
+  msg->_headers_index = NULL;
+  msg->_headers_index_size = 0;
+  msg->_headers_index_len = 0;
+}
+
+/* Index size is power of two, at least twice the number of headers so every
+   name fits. Returns false if index cannot be allocated. */
+static inline bool cmsc_sipmsg_index_create(struct cmsc_SipMessage *msg) {
+  uint32_t headers_len = 0;
+  struct cmsc_SipHeader *header;
+  STAILQ_FOREACH(header, &msg->sip_headers, _next) { headers_len++; }
+
+  uint32_t index_size = 4;
+  while (index_size < headers_len * 2) {
+    index_size *= 2;
+  }
+
+  msg->_headers_index =
+      calloc(index_size, sizeof(struct cmsc_SipHeadersIndexSlot));
+  if (!msg->_headers_index) {
+    return false;
+  }
+  msg->_headers_index_size = index_size;
+  msg->_headers_index_len = 0;
+
+  STAILQ_FOREACH(header, &msg->sip_headers, _next) {
+    cmsc_sipmsg_index_header(header, msg);
+  }
+
+  return true;
+}
+#endif
+
 #endif
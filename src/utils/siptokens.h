@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_SIPTOKENS_H
+#define C_MINILIB_SIP_CODEC_SIPTOKENS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include "c_minilib_sip_codec.h"
+
+struct cmsc_TokenLogic {
+  struct cmsc_String name;
+  uint32_t id;
+};
+
+struct cmsc_TokensTable {
+  const struct cmsc_TokenLogic *tokens;
+  uint32_t len;
+  // According RFC 3261 7.3.1 tokens are case-insensitive, methods are not.
+  bool is_case_sensitive;
+};
+
+#define CMSC_TOKEN(name_, id_)                                                 \
+  {.name = {.buf = name_, .len = sizeof(name_) - 1}, .id = id_}
+
+static inline const struct cmsc_TokensTable *cmsc_siptokens_methods(void) {
+  static const struct cmsc_TokenLogic methods[] = {
+      CMSC_TOKEN("INVITE", cmsc_SipMethods_INVITE),
+      CMSC_TOKEN("ACK", cmsc_SipMethods_ACK),
+      CMSC_TOKEN("BYE", cmsc_SipMethods_BYE),
+      CMSC_TOKEN("CANCEL", cmsc_SipMethods_CANCEL),
+      CMSC_TOKEN("OPTIONS", cmsc_SipMethods_OPTIONS),
+      CMSC_TOKEN("REGISTER", cmsc_SipMethods_REGISTER),
+      CMSC_TOKEN("PRACK", cmsc_SipMethods_PRACK),
+      CMSC_TOKEN("SUBSCRIBE", cmsc_SipMethods_SUBSCRIBE),
+      CMSC_TOKEN("NOTIFY", cmsc_SipMethods_NOTIFY),
+      CMSC_TOKEN("PUBLISH", cmsc_SipMethods_PUBLISH),
+      CMSC_TOKEN("INFO", cmsc_SipMethods_INFO),
+      CMSC_TOKEN("REFER", cmsc_SipMethods_REFER),
+      CMSC_TOKEN("MESSAGE", cmsc_SipMethods_MESSAGE),
+      CMSC_TOKEN("UPDATE", cmsc_SipMethods_UPDATE),
+  };
+  static const struct cmsc_TokensTable table = {
+      .tokens = methods,
+      .len = sizeof(methods) / sizeof(struct cmsc_TokenLogic),
+      .is_case_sensitive = true,
+  };
+
+  return &table;
+}
+
+static inline const struct cmsc_TokensTable *cmsc_siptokens_option_tags(void) {
+  static const struct cmsc_TokenLogic option_tags[] = {
+      CMSC_TOKEN("100rel", cmsc_SipOptionTags_100REL),
+      CMSC_TOKEN("timer", cmsc_SipOptionTags_TIMER),
+      CMSC_TOKEN("replaces", cmsc_SipOptionTags_REPLACES),
+      CMSC_TOKEN("path", cmsc_SipOptionTags_PATH),
+      CMSC_TOKEN("gruu", cmsc_SipOptionTags_GRUU),
+      CMSC_TOKEN("outbound", cmsc_SipOptionTags_OUTBOUND),
+      CMSC_TOKEN("norefersub", cmsc_SipOptionTags_NOREFERSUB),
+      CMSC_TOKEN("precondition", cmsc_SipOptionTags_PRECONDITION),
+      CMSC_TOKEN("eventlist", cmsc_SipOptionTags_EVENTLIST),
+      CMSC_TOKEN("join", cmsc_SipOptionTags_JOIN),
+      CMSC_TOKEN("histinfo", cmsc_SipOptionTags_HISTINFO),
+      CMSC_TOKEN("from-change", cmsc_SipOptionTags_FROM_CHANGE),
+      CMSC_TOKEN("sec-agree", cmsc_SipOptionTags_SEC_AGREE),
+      CMSC_TOKEN("tdialog", cmsc_SipOptionTags_TDIALOG),
+      CMSC_TOKEN("199", cmsc_SipOptionTags_199),
+  };
+  static const struct cmsc_TokensTable table = {
+      .tokens = option_tags,
+      .len = sizeof(option_tags) / sizeof(struct cmsc_TokenLogic),
+      .is_case_sensitive = false,
+  };
+
+  return &table;
+}
+
+static inline const struct cmsc_TokensTable *cmsc_siptokens_media_types(void) {
+  static const struct cmsc_TokenLogic media_types[] = {
+      CMSC_TOKEN("application/sdp", cmsc_MediaTypes_APPLICATION_SDP),
+      CMSC_TOKEN("application/pidf+xml", cmsc_MediaTypes_APPLICATION_PIDF_XML),
+      CMSC_TOKEN("application/rlmi+xml", cmsc_MediaTypes_APPLICATION_RLMI_XML),
+      CMSC_TOKEN("application/dialog-info+xml",
+                 cmsc_MediaTypes_APPLICATION_DIALOG_INFO_XML),
+      CMSC_TOKEN("application/simple-message-summary",
+                 cmsc_MediaTypes_APPLICATION_SIMPLE_MESSAGE_SUMMARY),
+      CMSC_TOKEN("application/isup", cmsc_MediaTypes_APPLICATION_ISUP),
+      CMSC_TOKEN("application/dtmf-relay",
+                 cmsc_MediaTypes_APPLICATION_DTMF_RELAY),
+      CMSC_TOKEN("message/sipfrag", cmsc_MediaTypes_MESSAGE_SIPFRAG),
+      CMSC_TOKEN("multipart/mixed", cmsc_MediaTypes_MULTIPART_MIXED),
+      CMSC_TOKEN("multipart/alternative",
+                 cmsc_MediaTypes_MULTIPART_ALTERNATIVE),
+      CMSC_TOKEN("multipart/related", cmsc_MediaTypes_MULTIPART_RELATED),
+      CMSC_TOKEN("text/plain", cmsc_MediaTypes_TEXT_PLAIN),
+  };
+  // According RFC 2045 5.1 type and subtype are case-insensitive.
+  static const struct cmsc_TokensTable table = {
+      .tokens = media_types,
+      .len = sizeof(media_types) / sizeof(struct cmsc_TokenLogic),
+      .is_case_sensitive = false,
+  };
+
+  return &table;
+}
+
+static inline const struct cmsc_TokensTable *
+cmsc_siptokens_subscription_states(void) {
+  static const struct cmsc_TokenLogic subscription_states[] = {
+      CMSC_TOKEN("active", cmsc_SubscriptionStates_ACTIVE),
+      CMSC_TOKEN("pending", cmsc_SubscriptionStates_PENDING),
+      CMSC_TOKEN("terminated", cmsc_SubscriptionStates_TERMINATED),
+  };
+  static const struct cmsc_TokensTable table = {
+      .tokens = subscription_states,
+      .len = sizeof(subscription_states) / sizeof(struct cmsc_TokenLogic),
+      .is_case_sensitive = false,
+  };
+
+  return &table;
+}
+
+#undef CMSC_TOKEN
+
+// Returns 0 if token is not well known.
+static inline uint32_t
+cmsc_siptokens_lookup(const struct cmsc_TokensTable *table,
+                      const struct cmsc_String token) {
+  for (uint32_t i = 0; i < table->len; i++) {
+    if (table->tokens[i].name.len != token.len) {
+      continue;
+    }
+
+    if (table->is_case_sensitive
+            ? strncmp(table->tokens[i].name.buf, token.buf, token.len) == 0
+            : strncasecmp(table->tokens[i].name.buf, token.buf, token.len) ==
+                  0) {
+      return table->tokens[i].id;
+    }
+  }
+
+  return 0;
+}
+
+#endif
@@ -84,6 +84,19 @@ cmsc_arg_iterator_emit_arg(struct cmsc_ArgIterator *arg_iter,
   return cmsc_ArgNextResults_ARG;
 }
 
+// Argument without `=`, like Via `rport`, has empty value.
+static inline enum cmsc_ArgNextResults
+cmsc_arg_iterator_emit_flag(struct cmsc_ArgIterator *arg_iter,
+                            const char *current_char, uint32_t offset) {
+  arg_iter->arg_key.buf = arg_iter->buf.buf;
+  arg_iter->arg_key.len = (uint32_t)(current_char - arg_iter->buf.buf);
+  arg_iter->arg_value.buf = current_char;
+  arg_iter->arg_value.len = 0;
+
+  cmsc_arg_iterator_traverse(arg_iter, current_char, offset);
+  return cmsc_ArgNextResults_ARG;
+}
+
 static inline enum cmsc_ArgNextResults
 cmsc_arg_iterator_next(struct cmsc_ArgIterator *arg_iter) {
   memset(&arg_iter->arg_key, 0, sizeof(struct cmsc_String));
@@ -101,6 +114,9 @@ cmsc_arg_iterator_next(struct cmsc_ArgIterator *arg_iter) {
       if (arg_iter->arg_key.buf) {
         return cmsc_arg_iterator_emit_arg(arg_iter, current_char, 1);
       }
+      if (current_char != arg_iter->buf.buf) {
+        return cmsc_arg_iterator_emit_flag(arg_iter, current_char, 1);
+      }
       break;
 
     case '=':
@@ -116,6 +132,9 @@ cmsc_arg_iterator_next(struct cmsc_ArgIterator *arg_iter) {
         if (arg_iter->arg_key.buf) {
           return cmsc_arg_iterator_emit_arg(arg_iter, current_char, 1);
         }
+        if (current_char != arg_iter->buf.buf) {
+          return cmsc_arg_iterator_emit_flag(arg_iter, current_char, 1);
+        }
       }
       break;
 
@@ -134,6 +153,10 @@ cmsc_arg_iterator_next(struct cmsc_ArgIterator *arg_iter) {
     return cmsc_arg_iterator_emit_arg(arg_iter, current_char, 0);
   }
 
+  if (current_char != arg_iter->buf.buf) {
+    return cmsc_arg_iterator_emit_flag(arg_iter, current_char, 0);
+  }
+
   return cmsc_ArgNextResults_NONE;
 }
 
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+
+#include "utils/bstring.h"
+#include "utils/buffer.h"
+
+static bool cmsc_template_is_name_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+// Returns start of next `${` in `text` or NULL if there is none.
+static const char *cmsc_template_next_open(const struct cmsc_String text) {
+  const char *end = text.buf + text.len;
+  const char *c = text.buf;
+  while ((c = memchr(c, '$', end - c))) {
+    if (c + 1 < end && c[1] == '{') {
+      return c;
+    }
+    c++;
+  }
+
+  return NULL;
+}
+
+static struct cmsc_String
+cmsc_template_name_to_string(const struct cmsc_Template *tmpl, uint32_t i) {
+  const struct cmsc_BString *name = &tmpl->names[i];
+  return (struct cmsc_String){.buf = tmpl->_buf.buf + name->buf_offset,
+                              .len = name->len};
+}
+
+// Returns `names_len` if template has no such name yet.
+static uint32_t cmsc_template_lookup(const struct cmsc_Template *tmpl,
+                                     const struct cmsc_String name) {
+  uint32_t i = 0;
+  for (; i < tmpl->names_len; i++) {
+    struct cmsc_String tmpl_name = cmsc_template_name_to_string(tmpl, i);
+    if (tmpl_name.len == name.len &&
+        strncmp(tmpl_name.buf, name.buf, name.len) == 0) {
+      break;
+    }
+  }
+
+  return i;
+}
+
+// Names are stored behind space reserved for the text.
+static cme_error_t cmsc_template_add_slot(const struct cmsc_String name,
+                                          struct cmsc_Template *tmpl) {
+  cme_error_t err;
+
+  if (tmpl->_slots_len >= CMSC_TEMPLATE_MAX_SLOTS) {
+    err = cme_errorf(ENOBUFS, "Template has more than %u placeholders",
+                     CMSC_TEMPLATE_MAX_SLOTS);
+    goto error_out;
+  }
+
+  uint32_t i = cmsc_template_lookup(tmpl, name);
+  if (i == tmpl->names_len) {
+    err = cmsc_buffer_binsert(name, &tmpl->_buf, &tmpl->names[i]);
+    if (err) {
+      goto error_out;
+    }
+    tmpl->names_len++;
+  }
+
+  tmpl->_slots[tmpl->_slots_len++] =
+      (struct cmsc_TemplateSlot){.offset = tmpl->_text_len, .name = i};
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_template_create(uint32_t buf_len, const char *buf,
+                                 struct cmsc_Template **tmpl) {
+  cme_error_t err;
+
+  if (!buf || !tmpl) {
+    err = cme_error(EINVAL, "`buf` and `tmpl` cannot be NULL");
+    goto error_out;
+  }
+
+  struct cmsc_Template *local_tmpl = calloc(1, sizeof(struct cmsc_Template));
+  if (!local_tmpl) {
+    err = cme_error(ENOMEM, "Cannot allocate memory for `local_tmpl`");
+    goto error_out;
+  }
+
+  // Neither text nor names are longer than `buf`, so buffer never grows
+  local_tmpl->_buf = (struct cmsc_Buffer){
+      .buf = malloc(buf_len * 2 + 1), .len = buf_len, .size = buf_len * 2 + 1};
+  if (!local_tmpl->_buf.buf) {
+    err = cme_error(ENOMEM, "Cannot allocate memory for `local_tmpl->_buf`");
+    goto error_tmpl_cleanup;
+  }
+
+  struct cmsc_String text = {.buf = buf, .len = buf_len};
+  while (text.len) {
+    const char *placeholder = cmsc_template_next_open(text);
+    uint32_t text_part_len = placeholder ? placeholder - text.buf : text.len;
+
+    memcpy((char *)local_tmpl->_buf.buf + local_tmpl->_text_len, text.buf,
+           text_part_len);
+    local_tmpl->_text_len += text_part_len;
+    if (!placeholder) {
+      break;
+    }
+
+    struct cmsc_String name = {.buf = placeholder + 2, .len = 0};
+    const char *text_end = text.buf + text.len;
+    while (name.buf + name.len < text_end &&
+           cmsc_template_is_name_char(name.buf[name.len])) {
+      name.len++;
+    }
+
+    if (!name.len || name.buf + name.len >= text_end ||
+        name.buf[name.len] != '}') {
+      err = cme_errorf(EINVAL, "Invalid placeholder at offset %u",
+                       (uint32_t)(placeholder - buf));
+      goto error_tmpl_cleanup;
+    }
+
+    err = cmsc_template_add_slot(name, local_tmpl);
+    if (err) {
+      goto error_tmpl_cleanup;
+    }
+
+    text.len = text_end - (name.buf + name.len + 1);
+    text.buf = name.buf + name.len + 1;
+  }
+
+  *tmpl = local_tmpl;
+
+  return 0;
+
+error_tmpl_cleanup:
+  cmsc_template_destroy(&local_tmpl);
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_template_create_from_sip(const struct cmsc_SipMessage *msg,
+                                          struct cmsc_Template **tmpl) {
+  cme_error_t err;
+
+  if (!msg || !tmpl) {
+    err = cme_error(EINVAL, "`msg` and `tmpl` cannot be NULL");
+    goto error_out;
+  }
+
+  uint32_t buf_len;
+  const char *buf;
+  err = cmsc_generate_sip(msg, &buf_len, &buf);
+  if (err) {
+    goto error_out;
+  }
+
+  err = cmsc_template_create(buf_len, buf, tmpl);
+  free((void *)buf);
+  if (err) {
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+void cmsc_template_destroy(struct cmsc_Template **tmpl) {
+  if (!tmpl || !*tmpl) {
+    return;
+  }
+
+  free((void *)(*tmpl)->_buf.buf);
+  free(*tmpl);
+
+  *tmpl = NULL;
+}
+
+cme_error_t cmsc_template_find(const struct cmsc_Template *tmpl,
+                               const char *name, uint32_t *index) {
+  cme_error_t err;
+
+  if (!tmpl || !name || !index) {
+    err = cme_error(EINVAL, "`tmpl`, `name` and `index` cannot be NULL");
+    goto error_out;
+  }
+
+  uint32_t i = cmsc_template_lookup(
+      tmpl, (struct cmsc_String){.buf = name, .len = strlen(name)});
+  if (i == tmpl->names_len) {
+    err = cme_errorf(ENOENT, "Template has no placeholder %s", name);
+    goto error_out;
+  }
+
+  *index = i;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static uint32_t cmsc_template_size(const struct cmsc_Template *tmpl,
+                                   const struct cmsc_String *values) {
+  uint32_t size = tmpl->_text_len;
+  for (uint32_t i = 0; i < tmpl->_slots_len; i++) {
+    size += values[tmpl->_slots[i].name].len;
+  }
+
+  return size;
+}
+
+// `dst` has to hold cmsc_template_size bytes.
+static void cmsc_template_copy(const struct cmsc_Template *tmpl,
+                               const struct cmsc_String *values, char *dst) {
+  uint32_t text_offset = 0;
+  for (uint32_t i = 0; i < tmpl->_slots_len; i++) {
+    const struct cmsc_TemplateSlot *slot = &tmpl->_slots[i];
+    const struct cmsc_String *value = &values[slot->name];
+
+    memcpy(dst, tmpl->_buf.buf + text_offset, slot->offset - text_offset);
+    dst += slot->offset - text_offset;
+    if (value->len) {
+      memcpy(dst, value->buf, value->len);
+      dst += value->len;
+    }
+    text_offset = slot->offset;
+  }
+  memcpy(dst, tmpl->_buf.buf + text_offset, tmpl->_text_len - text_offset);
+}
+
+static cme_error_t cmsc_template_check_values(const struct cmsc_Template *tmpl,
+                                              const struct cmsc_String *values,
+                                              uint32_t values_len) {
+  cme_error_t err;
+
+  if (!values && tmpl->names_len) {
+    err = cme_error(EINVAL, "`values` cannot be NULL");
+    goto error_out;
+  }
+
+  if (values_len < tmpl->names_len) {
+    err = cme_errorf(EINVAL, "Template needs %u values, got %u",
+                     tmpl->names_len, values_len);
+    goto error_out;
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_template_render(const struct cmsc_Template *tmpl,
+                                 const struct cmsc_String *values,
+                                 uint32_t values_len, char *dst, uint32_t cap,
+                                 uint32_t *len) {
+  cme_error_t err;
+
+  if (!tmpl || !dst || !len) {
+    err = cme_error(EINVAL, "`tmpl`, `dst` and `len` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_template_check_values(tmpl, values, values_len);
+  if (err) {
+    goto error_out;
+  }
+
+  uint32_t size = cmsc_template_size(tmpl, values);
+  if (size > cap) {
+    *len = size;
+    err = cme_errorf(ENOBUFS, "Rendered template needs %u bytes, got %u", size,
+                     cap);
+    goto error_out;
+  }
+
+  cmsc_template_copy(tmpl, values, dst);
+  *len = size;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+cme_error_t cmsc_template_render_many(const struct cmsc_Template *tmpl,
+                                      const struct cmsc_String *values,
+                                      uint32_t values_len, uint32_t count,
+                                      char *dst, uint32_t cap, uint32_t *lens) {
+  cme_error_t err;
+
+  if (!tmpl || (!dst && count) || (!lens && count)) {
+    err = cme_error(EINVAL, "`tmpl`, `dst` and `lens` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_template_check_values(tmpl, values, values_len);
+  if (err) {
+    goto error_out;
+  }
+
+  uint64_t size = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    lens[i] = cmsc_template_size(tmpl, &values[i * values_len]);
+    size += lens[i];
+  }
+
+  if (size > cap) {
+    err = cme_errorf(ENOBUFS, "Rendered templates need %llu bytes, got %u",
+                     (unsigned long long)size, cap);
+    goto error_out;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    cmsc_template_copy(tmpl, &values[i * values_len], dst);
+    dst += lens[i];
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static cme_error_t cmsc_template_push_iov(const char *buf, uint32_t len,
+                                          struct iovec *iov, uint32_t iov_cap,
+                                          uint32_t *iov_len) {
+  if (!len) {
+    return 0;
+  }
+
+  if (*iov_len >= iov_cap) {
+    return cme_error(ENOBUFS, "Iovecs array is too small");
+  }
+
+  iov[(*iov_len)++] = (struct iovec){.iov_base = (void *)buf, .iov_len = len};
+
+  return 0;
+}
+
+cme_error_t cmsc_template_render_iov(const struct cmsc_Template *tmpl,
+                                     const struct cmsc_String *values,
+                                     uint32_t values_len, struct iovec *iov,
+                                     uint32_t iov_cap, uint32_t *iov_len) {
+  cme_error_t err;
+
+  if (!tmpl || !iov || !iov_len) {
+    err = cme_error(EINVAL, "`tmpl`, `iov` and `iov_len` cannot be NULL");
+    goto error_out;
+  }
+
+  err = cmsc_template_check_values(tmpl, values, values_len);
+  if (err) {
+    goto error_out;
+  }
+
+  uint32_t text_offset = 0;
+  uint32_t local_iov_len = 0;
+  for (uint32_t i = 0; i < tmpl->_slots_len; i++) {
+    const struct cmsc_TemplateSlot *slot = &tmpl->_slots[i];
+    const struct cmsc_String *value = &values[slot->name];
+
+    err = cmsc_template_push_iov(tmpl->_buf.buf + text_offset,
+                                 slot->offset - text_offset, iov, iov_cap,
+                                 &local_iov_len);
+    if (err) {
+      goto error_out;
+    }
+
+    err = cmsc_template_push_iov(value->buf, value->len, iov, iov_cap,
+                                 &local_iov_len);
+    if (err) {
+      goto error_out;
+    }
+
+    text_offset = slot->offset;
+  }
+
+  err = cmsc_template_push_iov(tmpl->_buf.buf + text_offset,
+                               tmpl->_text_len - text_offset, iov, iov_cap,
+                               &local_iov_len);
+  if (err) {
+    goto error_out;
+  }
+
+  *iov_len = local_iov_len;
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#ifndef C_MINILIB_SIP_CODEC_WRITER_H
+#define C_MINILIB_SIP_CODEC_WRITER_H
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+
+#include "c_minilib_error.h"
+#include "c_minilib_sip_codec.h"
+#include "utils/buffer.h"
+
+// Shorter parts are copied to scratch even if they are in source.
+#ifndef CMSC_WRITER_REF_MIN_LEN
+#define CMSC_WRITER_REF_MIN_LEN 16
+#endif
+
+/* Destination of encoded parts. Without `iov` parts are appended to `buffer`,
+   see cmsc_buffer_insert_parts. With `iov` parts lying in `source` are
+   referenced by iovecs and other parts are copied to `buffer`, which is then
+   fixed size scratch and never grows. */
+struct cmsc_Writer {
+  struct cmsc_Buffer buffer;
+  // Buffer is owned by caller, it is never grown and overflow gives ENOBUFS
+  bool is_fixed_size;
+  struct iovec *iov;
+  uint32_t iov_len;
+  uint32_t iov_cap;
+  struct cmsc_String source;
+};
+
+/* Header name with separator, message in compact form gets compact name if
+   header has one and no space after colon. */
+static inline struct cmsc_String
+cmsc_writer_header_name(const struct cmsc_SipMessage *msg,
+                        enum cmsc_SupportedSipHeaders id) {
+  switch (id) {
+#define CMSC_X(hid, suffix, field, type, hname, hcompact_name, is_encoded)     \
+  case cmsc_SupportedSipHeaders_##hid:                                         \
+    if (!msg->is_compact_form) {                                               \
+      return CMSC_BUFFER_LITERAL(hname ": ");                                  \
+    }                                                                          \
+    return sizeof(hcompact_name) > 1 ? CMSC_BUFFER_LITERAL(hcompact_name ":")  \
+                                     : CMSC_BUFFER_LITERAL(hname ":");
+    CMSC_SIP_HEADERS(CMSC_X)
+#undef CMSC_X
+  default:
+    return CMSC_BUFFER_LITERAL("");
+  }
+}
+
+static inline bool cmsc_writer_is_in_source(const struct cmsc_Writer *writer,
+                                            const struct cmsc_String part) {
+  uintptr_t source = (uintptr_t)writer->source.buf;
+  uintptr_t start = (uintptr_t)part.buf;
+
+  return start >= source && start + part.len <= source + writer->source.len;
+}
+
+static inline cme_error_t cmsc_writer_scatter(const struct cmsc_String part,
+                                              struct cmsc_Writer *writer) {
+  struct cmsc_Buffer *scratch = &writer->buffer;
+  const char *base = part.buf;
+  cme_error_t err;
+
+  if (part.len < CMSC_WRITER_REF_MIN_LEN ||
+      !cmsc_writer_is_in_source(writer, part)) {
+    if (part.len > scratch->size - scratch->len) {
+      err = cme_error(ENOBUFS, "Scratch buffer is too small");
+      goto error_out;
+    }
+
+    base = scratch->buf + scratch->len;
+    memcpy((char *)base, part.buf, part.len);
+    scratch->len += part.len;
+  }
+
+  // Consecutive scratch parts are contiguous, so they share one iovec
+  if (writer->iov_len) {
+    struct iovec *last = &writer->iov[writer->iov_len - 1];
+    if ((const char *)last->iov_base + last->iov_len == base) {
+      last->iov_len += part.len;
+      return 0;
+    }
+  }
+
+  if (writer->iov_len >= writer->iov_cap) {
+    err = cme_error(ENOBUFS, "Iovecs array is too small");
+    goto error_out;
+  }
+
+  writer->iov[writer->iov_len++] =
+      (struct iovec){.iov_base = (void *)base, .iov_len = part.len};
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+static inline cme_error_t
+cmsc_writer_insert_parts(const struct cmsc_String *parts, uint32_t parts_len,
+                         struct cmsc_Writer *writer) {
+  cme_error_t err;
+
+  if (!writer->iov && writer->is_fixed_size) {
+    uint32_t len = 0;
+    for (uint32_t i = 0; i < parts_len; i++) {
+      len += parts[i].len;
+    }
+
+    if (len > writer->buffer.size - writer->buffer.len) {
+      err = cme_error(ENOBUFS, "Fixed size buffer is too small");
+      goto error_out;
+    }
+  }
+
+  if (!writer->iov) {
+    return cmsc_buffer_insert_parts(parts, parts_len, &writer->buffer);
+  }
+
+  for (uint32_t i = 0; i < parts_len; i++) {
+    if (!parts[i].len) {
+      continue;
+    }
+
+    err = cmsc_writer_scatter(parts[i], writer);
+    if (err) {
+      goto error_out;
+    }
+  }
+
+  return 0;
+
+error_out:
+  return cme_return(err);
+}
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+#include "utils/bstring.h"
+#include "utils/sipmsg.h"
+
+static struct cmsc_SipMessage *msg = NULL;
+static const char *out_buf = NULL;
+
+void setUp(void) {
+  TEST_ASSERT_NULL(cmsc_init());
+  msg = NULL;
+  out_buf = NULL;
+}
+
+void tearDown(void) {
+  free((void *)out_buf);
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
+
+void test_generated_headers_are_decoded(void) {
+  const char *raw = "UPDATE sip:bob@example.com SIP/2.0\r\n"
+                    "x: 1800;lr;refresher=uac\r\n"
+                    "Min-SE: 90\r\n"
+                    "Priority: urgent\r\n"
+                    "\r\n";
+
+  TEST_ASSERT_NULL(cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg));
+
+  TEST_ASSERT_TRUE(cmsc_sipmsg_is_field_present(
+      msg, cmsc_SupportedSipHeaders_SESSION_EXPIRES));
+  TEST_ASSERT_EQUAL(1800, msg->session_expires.delta);
+  ASSERT_BSTRING("uac", msg->session_expires.refresher);
+  ASSERT_BSTRING("lr;refresher=uac", msg->session_expires.params);
+
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_MIN_SE));
+  TEST_ASSERT_EQUAL(90, msg->min_se.delta);
+  TEST_ASSERT_EQUAL(0, msg->min_se.params.len);
+
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_PRIORITY));
+  ASSERT_BSTRING("urgent", msg->priority.value);
+
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->sip_headers));
+}
+
+void test_generated_headers_are_generated(void) {
+  const char *raw = "UPDATE sip:bob@example.com SIP/2.0\r\n"
+                    "Priority: non-urgent\r\n"
+                    "Session-Expires: 4000 ; refresher=uas\r\n"
+                    "\r\n";
+
+  TEST_ASSERT_NULL(cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  TEST_ASSERT_EQUAL_STRING("UPDATE sip:bob@example.com SIP/2.0\r\n"
+                           "Session-Expires: 4000;refresher=uas\r\n"
+                           "Priority: non-urgent\r\n"
+                           "\r\n",
+                           out_buf);
+}
+
+void test_generated_headers_malformed(void) {
+  const char *malformed[] = {
+      "Session-Expires: soon\r\n",
+      "Session-Expires: 90;refresher=u a c\r\n",
+      "Min-SE: 90;=1\r\n",
+      "Priority: urgent;x=1\r\n",
+      "Priority: very urgent\r\n",
+  };
+  char raw[256];
+
+  for (uint32_t i = 0; i < sizeof(malformed) / sizeof(char *); i++) {
+    snprintf(raw, sizeof(raw), "UPDATE sip:bob@example.com SIP/2.0\r\n%s\r\n",
+             malformed[i]);
+
+    cme_error_t err = cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg);
+    TEST_ASSERT_NOT_NULL(err);
+    cmsc_sipmsg_destroy(&msg);
+  }
+}
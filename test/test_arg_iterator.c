@@ -126,6 +126,12 @@ void test_argument_without_value(void) {
   MYTEST_ASSERT_EQUAL_STRING_LEN("foo", it.value.buf, it.value.len);
 
   // 2. ARG -> no_value_key
+  res = cmsc_arg_iterator_next(&it);
+  TEST_ASSERT_EQUAL(cmsc_ArgNextResults_ARG, res);
+  MYTEST_ASSERT_EQUAL_STRING_LEN("no_value_key", it.arg_key.buf,
+                                 it.arg_key.len);
+  TEST_ASSERT_EQUAL(0, it.arg_value.len);
+
   res = cmsc_arg_iterator_next(&it);
   TEST_ASSERT_EQUAL(cmsc_ArgNextResults_NONE, res);
 }
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+
+static struct cmsc_SipMessage *msg = NULL;
+static struct cmsc_Builder builder;
+static char out[512];
+
+void setUp(void) {
+  TEST_ASSERT_NULL(cmsc_init());
+  msg = NULL;
+  TEST_ASSERT_NULL(cmsc_builder_init(out, sizeof(out), &builder));
+}
+
+void tearDown(void) {
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
+
+#define ADD_HEADER(name, value)                                                \
+  cmsc_builder_add_header(strlen(name), name, strlen(value), value, &builder)
+
+void test_builder_request_with_body(void) {
+  const char *sdp = "v=0\r\n"
+                    "o=alice 2890844526 2890844526 IN IP4 pc33.example.com\r\n";
+
+  TEST_ASSERT_NULL(cmsc_builder_begin_request(strlen("INVITE"), "INVITE",
+                                              strlen("sip:bob@example.com"),
+                                              "sip:bob@example.com", &builder));
+  TEST_ASSERT_NULL(cmsc_builder_add_via(
+      strlen("SIP/2.0/UDP"), "SIP/2.0/UDP", strlen("pc33.example.com"),
+      "pc33.example.com", strlen("z9hG4bK776"), "z9hG4bK776", &builder));
+  TEST_ASSERT_NULL(ADD_HEADER("Call-ID", "a84b4c76e66710"));
+  TEST_ASSERT_NULL(ADD_HEADER("CSeq", "314159 INVITE"));
+  TEST_ASSERT_NULL(ADD_HEADER("Content-Type", "application/sdp"));
+
+  // Body is streamed in chunks
+  TEST_ASSERT_NULL(cmsc_builder_set_body(5, sdp, &builder));
+  TEST_ASSERT_NULL(cmsc_builder_set_body(strlen(sdp) - 5, sdp + 5, &builder));
+
+  cme_error_t err = ADD_HEADER("Max-Forwards", "70");
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+
+  uint32_t out_len;
+  TEST_ASSERT_NULL(cmsc_builder_finish(&builder, &out_len));
+
+  char expected[512];
+  snprintf(expected, sizeof(expected),
+           "INVITE sip:bob@example.com SIP/2.0\r\n"
+           "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+           "Call-ID: a84b4c76e66710\r\n"
+           "CSeq: 314159 INVITE\r\n"
+           "Content-Type: application/sdp\r\n"
+           "Content-Length:  %zu\r\n"
+           "\r\n"
+           "%s",
+           strlen(sdp), sdp);
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected, out, out_len);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(out_len, out, &msg));
+  TEST_ASSERT_EQUAL(strlen(sdp), msg->content_length);
+  TEST_ASSERT_EQUAL(strlen(sdp), msg->body.len);
+}
+
+void test_builder_response_without_body(void) {
+  cme_error_t err = ADD_HEADER("Call-ID", "a84b4c76e66710");
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+
+  TEST_ASSERT_NULL(
+      cmsc_builder_begin_response(200, strlen("OK"), "OK", &builder));
+  TEST_ASSERT_NULL(ADD_HEADER("Call-ID", "a84b4c76e66710"));
+
+  uint32_t out_len;
+  TEST_ASSERT_NULL(cmsc_builder_finish(&builder, &out_len));
+
+  const char *expected = "SIP/2.0 200 OK\r\n"
+                         "Call-ID: a84b4c76e66710\r\n"
+                         "Content-Length: 0\r\n"
+                         "\r\n";
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected, out, out_len);
+
+  err = cmsc_builder_set_body(2, "v=", &builder);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+}
+
+void test_builder_buffer_too_small(void) {
+  char small[32];
+  TEST_ASSERT_NULL(cmsc_builder_init(small, sizeof(small), &builder));
+  TEST_ASSERT_NULL(
+      cmsc_builder_begin_response(100, strlen("Trying"), "Trying", &builder));
+
+  // Header which does not fit leaves builder unchanged
+  cme_error_t err = ADD_HEADER("Call-ID", "a84b4c76e66710");
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+
+  err = cmsc_builder_finish(&builder, &(uint32_t){0});
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+}
+
+void test_builder_failed_body_leaves_headers_open(void) {
+  char small[64];
+  TEST_ASSERT_NULL(cmsc_builder_init(small, sizeof(small), &builder));
+  TEST_ASSERT_NULL(
+      cmsc_builder_begin_response(200, strlen("OK"), "OK", &builder));
+
+  // Content-Length line fits, but body does not, so none of them is written
+  uint32_t len = builder._len;
+  cme_error_t err = cmsc_builder_set_body(40, out, &builder);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+  TEST_ASSERT_EQUAL(len, builder._len);
+  TEST_ASSERT_NULL(ADD_HEADER("Call-ID", "a84b"));
+
+  // Builder writes Content-Length itself
+  const char *names[] = {"Content-Length", "content-length", "l", "L"};
+  for (uint32_t i = 0; i < sizeof(names) / sizeof(char *); i++) {
+    err = ADD_HEADER(names[i], "4");
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL(EINVAL, err->code);
+  }
+
+  TEST_ASSERT_NULL(cmsc_builder_set_body(4, "body", &builder));
+
+  uint32_t out_len;
+  TEST_ASSERT_NULL(cmsc_builder_finish(&builder, &out_len));
+
+  const char *expected = "SIP/2.0 200 OK\r\n"
+                         "Call-ID: a84b\r\n"
+                         "Content-Length:  4\r\n"
+                         "\r\n"
+                         "body";
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected, small, out_len);
+}
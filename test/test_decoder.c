@@ -4,6 +4,8 @@
  * See LICENSE file in the project root for full license information.
  */
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unity.h>
@@ -19,8 +21,11 @@
 
 static struct cmsc_SipMessage *msg = NULL;
 
-void setUp(void) {}
-void tearDown(void) { cmsc_sipmsg_destroy_with_buf(&msg); }
+void setUp(void) { TEST_ASSERT_NULL(cmsc_init()); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy_with_buf(&msg);
+  cmsc_destroy();
+}
 
 void test_decode_to_header(void) {
   const char *raw_to_value = "To: <sip:bob@example.com>;tag=123abc";
@@ -163,3 +168,446 @@ void test_decode_content_length_header(void) {
   // `cmsc_SipMessage`
   TEST_ASSERT_EQUAL(123, msg->content_length);
 }
+
+void test_resolve_via_received_and_rport(void) {
+  const char *raw_value = "Via: SIP/2.0/UDP host.example.com:5070"
+                          ";branch=z9hG4bK;received=192.0.2.4;rport=6000";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  err = cmsc_resolve_sip_vias(msg);
+  TEST_ASSERT_NULL(err);
+
+  struct cmsc_SipHeaderVia *via = STAILQ_FIRST(&msg->vias);
+  TEST_ASSERT_NOT_NULL(via);
+  TEST_ASSERT_EQUAL(6000, via->rport);
+  TEST_ASSERT_TRUE(via->is_route_addr_resolved);
+
+  struct sockaddr_in *addr = (struct sockaddr_in *)&via->route_addr;
+  TEST_ASSERT_EQUAL(AF_INET, addr->sin_family);
+  TEST_ASSERT_EQUAL(6000, ntohs(addr->sin_port));
+  TEST_ASSERT_EQUAL(htonl(0xC0000204), addr->sin_addr.s_addr);
+}
+
+void test_resolve_via_ipv6_sent_by(void) {
+  const char *raw_value = "Via: SIP/2.0/TLS [2001:db8::9]:5080;branch=z9hG4bK";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  err = cmsc_resolve_sip_vias(msg);
+  TEST_ASSERT_NULL(err);
+
+  struct cmsc_SipHeaderVia *via = STAILQ_FIRST(&msg->vias);
+  TEST_ASSERT_NOT_NULL(via);
+  TEST_ASSERT_TRUE(via->is_route_addr_resolved);
+
+  struct sockaddr_in6 *addr = (struct sockaddr_in6 *)&via->route_addr;
+  TEST_ASSERT_EQUAL(AF_INET6, addr->sin6_family);
+  TEST_ASSERT_EQUAL(5080, ntohs(addr->sin6_port));
+  TEST_ASSERT_EQUAL(0x20, addr->sin6_addr.s6_addr[0]);
+  TEST_ASSERT_EQUAL(0x09, addr->sin6_addr.s6_addr[15]);
+}
+
+void test_resolve_via_hostname_unresolved(void) {
+  const char *raw_value = "Via: SIP/2.0/UDP host.example.com;branch=z9hG4bK";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  err = cmsc_resolve_sip_vias(msg);
+  TEST_ASSERT_NULL(err);
+
+  struct cmsc_SipHeaderVia *via = STAILQ_FIRST(&msg->vias);
+  TEST_ASSERT_NOT_NULL(via);
+  TEST_ASSERT_TRUE(!via->is_route_addr_resolved);
+}
+
+void test_decode_via_rport(void) {
+  const char *invalid[] = {
+      "Via: SIP/2.0/UDP host.example.com;branch=z9hG4bK;rport=70000",
+      "Via: SIP/2.0/UDP host.example.com;branch=z9hG4bK;rport=60a",
+      "Via: SIP/2.0/UDP host.example.com;branch=z9hG4bK;rport=0",
+  };
+  cme_error_t err;
+
+  for (uint32_t i = 0; i < sizeof(invalid) / sizeof(char *); i++) {
+    create_msg(invalid[i], &msg);
+    create_hdr(msg);
+
+    err = cmsc_decode_sip_headers(msg);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL(EINVAL, err->code);
+    cmsc_sipmsg_destroy_with_buf(&msg);
+  }
+
+  // Requests ask for rport with empty value
+  create_msg("Via: SIP/2.0/UDP host.example.com;rport;branch=z9hG4bK", &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+  struct cmsc_SipHeaderVia *via = STAILQ_FIRST(&msg->vias);
+  TEST_ASSERT_TRUE(via->has_rport);
+  TEST_ASSERT_EQUAL(0, via->rport);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "z9hG4bK", cmsc_bs_msg_to_string(&via->branch, msg).buf,
+      via->branch.len);
+}
+
+void test_decode_supported_header_tokens(void) {
+  const char *raw_value = "Supported: 100rel, Timer,path ,x-custom";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->sip_headers));
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_SUPPORTED));
+  TEST_ASSERT_EQUAL(cmsc_SipOptionTags_100REL | cmsc_SipOptionTags_TIMER |
+                        cmsc_SipOptionTags_PATH,
+                    msg->supported.mask);
+
+  struct cmsc_SipToken *token = STAILQ_FIRST(&msg->supported.unknown);
+  TEST_ASSERT_NOT_NULL(token);
+  MYTEST_ASSERT_EQUAL_STRING_LEN("x-custom",
+                                 cmsc_bs_msg_to_string(&token->token, msg).buf,
+                                 token->token.len);
+  TEST_ASSERT_NULL(STAILQ_NEXT(token, _next));
+}
+
+void test_decode_allow_header_methods(void) {
+  const char *raw_value = "Allow: INVITE, ACK, CANCEL, BYE, OPTIONS, invite";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(cmsc_sip_tokens_has_all(
+      &msg->allow, cmsc_SipMethods_INVITE | cmsc_SipMethods_BYE));
+  TEST_ASSERT_TRUE(!cmsc_sip_tokens_has_all(&msg->allow, cmsc_SipMethods_INFO));
+
+  // Methods are case-sensitive
+  struct cmsc_SipToken *token = STAILQ_FIRST(&msg->allow.unknown);
+  TEST_ASSERT_NOT_NULL(token);
+  MYTEST_ASSERT_EQUAL_STRING_LEN("invite",
+                                 cmsc_bs_msg_to_string(&token->token, msg).buf,
+                                 token->token.len);
+}
+
+void test_decode_require_header_unsupported(void) {
+  const char *raw_value = "Require: 100rel, replaces";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(cmsc_SipOptionTags_REPLACES,
+                    cmsc_sip_tokens_unsupported(&msg->require,
+                                                cmsc_SipOptionTags_100REL |
+                                                    cmsc_SipOptionTags_TIMER));
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->require.unknown));
+}
+
+void test_decode_content_type_header(void) {
+  const char *raw_value =
+      "Content-Type: Multipart/Mixed; boundary=\"unique-42\" ;charset=utf-8";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->sip_headers));
+  TEST_ASSERT_TRUE(cmsc_sipmsg_is_field_present(
+      msg, cmsc_SupportedSipHeaders_CONTENT_TYPE));
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_MULTIPART_MIXED,
+                    msg->content_type.media_type);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "Multipart/Mixed",
+      cmsc_bs_msg_to_string(&msg->content_type.type, msg).buf,
+      msg->content_type.type.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "unique-42", cmsc_bs_msg_to_string(&msg->content_type.boundary, msg).buf,
+      msg->content_type.boundary.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "utf-8", cmsc_bs_msg_to_string(&msg->content_type.charset, msg).buf,
+      msg->content_type.charset.len);
+}
+
+void test_decode_content_type_compact_form(void) {
+  const char *raw_value = "c: application/sdp";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_APPLICATION_SDP,
+                    msg->content_type.media_type);
+  TEST_ASSERT_EQUAL(0, msg->content_type.params.len);
+  TEST_ASSERT_EQUAL(0, msg->content_type.boundary.len);
+}
+
+void test_decode_content_type_unknown(void) {
+  const char *raw_value = "Content-Type: application/x-private";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_UNKNOWN, msg->content_type.media_type);
+}
+
+void test_decode_event_header(void) {
+  const char *raw_value = "Event: presence;id=sub-7";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->sip_headers));
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_EVENT));
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "presence", cmsc_bs_msg_to_string(&msg->event.package, msg).buf,
+      msg->event.package.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN("sub-7",
+                                 cmsc_bs_msg_to_string(&msg->event.id, msg).buf,
+                                 msg->event.id.len);
+}
+
+void test_decode_subscription_state_header(void) {
+  const char *raw_value =
+      "Subscription-State: terminated;reason=timeout;retry-after=30";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(cmsc_sipmsg_is_field_present(
+      msg, cmsc_SupportedSipHeaders_SUBSCRIPTION_STATE));
+  TEST_ASSERT_EQUAL(cmsc_SubscriptionStates_TERMINATED,
+                    msg->subscription_state.state);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "timeout",
+      cmsc_bs_msg_to_string(&msg->subscription_state.reason, msg).buf,
+      msg->subscription_state.reason.len);
+  TEST_ASSERT_EQUAL(30, msg->subscription_state.retry_after);
+  TEST_ASSERT_EQUAL(0, msg->subscription_state.expires);
+}
+
+void test_decode_expires_header(void) {
+  const char *raw_value = "Expires: 3600";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(3600, msg->expires);
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_EXPIRES));
+}
+
+void test_decode_expires_header_malformed(void) {
+  const char *raw_value = "Expires: soon";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_decode_p_asserted_identity_multi_value(void) {
+  const char *raw_value = "P-Asserted-Identity: \"Alice, Ltd\" "
+                          "<sip:alice@example.com;user=phone>;x-src=gw1, "
+                          "tel:+15551234";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->sip_headers));
+  TEST_ASSERT_TRUE(cmsc_sipmsg_is_field_present(
+      msg, cmsc_SupportedSipHeaders_P_ASSERTED_IDENTITY));
+
+  struct cmsc_SipHeaderIdentity *identity =
+      STAILQ_FIRST(&msg->p_asserted_identities);
+  TEST_ASSERT_NOT_NULL(identity);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "Alice, Ltd", cmsc_bs_msg_to_string(&identity->display_name, msg).buf,
+      identity->display_name.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "sip:alice@example.com;user=phone",
+      cmsc_bs_msg_to_string(&identity->uri, msg).buf, identity->uri.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "x-src=gw1", cmsc_bs_msg_to_string(&identity->params, msg).buf,
+      identity->params.len);
+  TEST_ASSERT_TRUE(identity->is_name_addr);
+
+  identity = STAILQ_NEXT(identity, _next);
+  TEST_ASSERT_NOT_NULL(identity);
+  TEST_ASSERT_EQUAL(0, identity->display_name.len);
+  TEST_ASSERT_EQUAL(0, identity->params.len);
+  TEST_ASSERT_FALSE(identity->is_name_addr);
+  MYTEST_ASSERT_EQUAL_STRING_LEN("tel:+15551234",
+                                 cmsc_bs_msg_to_string(&identity->uri, msg).buf,
+                                 identity->uri.len);
+  TEST_ASSERT_NULL(STAILQ_NEXT(identity, _next));
+}
+
+void test_decode_diversion_header(void) {
+  const char *raw_value = "Diversion: <sip:bob@example.com>;reason=no-answer"
+                          ";counter=2, <sip:carol@example.com>;reason=busy";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  struct cmsc_SipHeaderDiversion *diversion = STAILQ_FIRST(&msg->diversions);
+  TEST_ASSERT_NOT_NULL(diversion);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "sip:bob@example.com", cmsc_bs_msg_to_string(&diversion->uri, msg).buf,
+      diversion->uri.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "no-answer", cmsc_bs_msg_to_string(&diversion->reason, msg).buf,
+      diversion->reason.len);
+  TEST_ASSERT_EQUAL(2, diversion->counter);
+
+  diversion = STAILQ_NEXT(diversion, _next);
+  TEST_ASSERT_NOT_NULL(diversion);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "busy", cmsc_bs_msg_to_string(&diversion->reason, msg).buf,
+      diversion->reason.len);
+  TEST_ASSERT_EQUAL(1, diversion->counter);
+}
+
+void test_decode_history_info_header(void) {
+  const char *raw_value =
+      "History-Info: <sip:bob@example.com?Reason=SIP%3Bcause%3D302>"
+      ";index=1.1;rc=1";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  struct cmsc_SipHeaderHistoryInfo *history_info =
+      STAILQ_FIRST(&msg->history_infos);
+  TEST_ASSERT_NOT_NULL(history_info);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "sip:bob@example.com?Reason=SIP%3Bcause%3D302",
+      cmsc_bs_msg_to_string(&history_info->uri, msg).buf,
+      history_info->uri.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "1.1", cmsc_bs_msg_to_string(&history_info->index, msg).buf,
+      history_info->index.len);
+  TEST_ASSERT_NULL(STAILQ_NEXT(history_info, _next));
+}
+
+void test_decode_via_header_multi_value(void) {
+  const char *raw_value = "Via: SIP/2.0/UDP p1.example.com;branch=z9hG4bK1, "
+                          "SIP/2.0/TCP p2.example.com;branch=z9hG4bK2";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  struct cmsc_SipHeaderVia *via = STAILQ_FIRST(&msg->vias);
+  TEST_ASSERT_NOT_NULL(via);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "SIP/2.0/UDP p1.example.com;branch=z9hG4bK1",
+      cmsc_bs_msg_to_string(&via->raw, msg).buf, via->raw.len);
+
+  via = STAILQ_NEXT(via, _next);
+  TEST_ASSERT_NOT_NULL(via);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "TCP", cmsc_bs_msg_to_string(&via->proto, msg).buf, via->proto.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "z9hG4bK2", cmsc_bs_msg_to_string(&via->branch, msg).buf,
+      via->branch.len);
+  TEST_ASSERT_NULL(STAILQ_NEXT(via, _next));
+}
+
+void test_decode_route_header(void) {
+  const char *raw_value =
+      "Route: <sip:p1.example.com;lr>, \"Edge\" <sip:p2.example.com;lr>;x=1";
+  cme_error_t err;
+
+  create_msg(raw_value, &msg);
+  create_hdr(msg);
+
+  err = cmsc_decode_sip_headers(msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_ROUTE));
+
+  struct cmsc_SipHeaderRoute *route = STAILQ_FIRST(&msg->routes);
+  TEST_ASSERT_NOT_NULL(route);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "sip:p1.example.com;lr", cmsc_bs_msg_to_string(&route->uri, msg).buf,
+      route->uri.len);
+
+  route = STAILQ_NEXT(route, _next);
+  TEST_ASSERT_NOT_NULL(route);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "Edge", cmsc_bs_msg_to_string(&route->display_name, msg).buf,
+      route->display_name.len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "x=1", cmsc_bs_msg_to_string(&route->params, msg).buf,
+      route->params.len);
+  TEST_ASSERT_NULL(STAILQ_NEXT(route, _next));
+}
@@ -11,17 +11,21 @@
 #include <unity.h>
 
 struct cmsc_SipMessage *msg;
+struct cmsc_SipMessage *resp;
 const char *out_buf;
 
 void setUp(void) {
-  cme_init();
+  TEST_ASSERT_NULL(cmsc_init());
   msg = NULL;
+  resp = NULL;
   out_buf = NULL;
 }
 
 void tearDown(void) {
   free((void *)out_buf);
+  cmsc_sipmsg_destroy_with_buf(&resp);
   cmsc_sipmsg_destroy_with_buf(&msg);
+  cmsc_destroy();
 }
 
 void test_generate_invite_exact_match(void) {
@@ -175,7 +179,8 @@ void test_generate_full_sip_request_invite(void) {
 
   cme_error_t err =
       cmsc_sipmsg_insert_via(strlen(proto), proto, strlen(sent_by), sent_by, 0,
-                             NULL, strlen(branch), branch, 0, NULL, ttl, msg);
+                             NULL, strlen(branch), branch, 0, NULL, ttl, false,
+                             msg);
   TEST_ASSERT_NULL(err);
 
   err = cmsc_sipmsg_insert_to(strlen("<sip:bob@example.com>"),
@@ -245,3 +250,665 @@ void test_generate_sip_request_with_body(void) {
 
   TEST_ASSERT_EQUAL_STRING(expected, out_buf);
 }
+
+void test_generate_parsed_token_lists(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "Allow: INVITE, BYE, FOO\r\n"
+                    "k: timer,100rel\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+
+  uint32_t out_len = 0;
+  cme_error_t err = cmsc_generate_sip(msg, &out_len, &out_buf);
+  TEST_ASSERT_NULL(err);
+
+  const char *expected = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                         "Allow: INVITE, BYE, FOO\r\n"
+                         "Supported: 100rel, timer\r\n"
+                         "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, out_buf, out_len);
+}
+
+void test_generate_via_rport(void) {
+  const char *proto = "SIP/2.0/UDP";
+  TEST_ASSERT_NULL(cmsc_sipmsg_create_with_buf(&msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_request_line(
+      7, "SIP/2.0", 19, "sip:bob@example.com", 7, "OPTIONS", msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_via(strlen(proto), proto, 13,
+                                          "a.example.com", 0, NULL, 8,
+                                          "z9hG4bK1", 0, NULL, 0, true, msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_via(strlen(proto), proto, 13,
+                                          "b.example.com", 0, NULL, 8,
+                                          "z9hG4bK2", 0, NULL, 0, true, msg));
+  // Server fills in port request came from, RFC 3581 4
+  STAILQ_NEXT(STAILQ_FIRST(&msg->vias), _next)->rport = 5070;
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  const char *expected =
+      "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP a.example.com;branch=z9hG4bK1;rport\r\n"
+      "Via: SIP/2.0/UDP b.example.com;branch=z9hG4bK2;rport=5070\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, out_buf, out_len);
+}
+
+void test_generate_notify_presence_headers(void) {
+  TEST_ASSERT_NULL(cmsc_sipmsg_create_with_buf(&msg));
+
+  const char *method = "NOTIFY";
+  const char *uri = "sip:watcher@example.com";
+  const char *version = "SIP/2.0";
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_request_line(
+      strlen(version), version, strlen(uri), uri, strlen(method), method, msg));
+
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_event(strlen("presence"), "presence",
+                                            strlen("id=1"), "id=1", msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_subscription_state(
+      strlen("active"), "active", strlen("expires=600"), "expires=600", msg));
+  TEST_ASSERT_EQUAL(cmsc_SubscriptionStates_ACTIVE,
+                    msg->subscription_state.state);
+  TEST_ASSERT_EQUAL(600, msg->subscription_state.expires);
+
+  uint32_t out_len = 0;
+  cme_error_t err = cmsc_generate_sip(msg, &out_len, &out_buf);
+  TEST_ASSERT_NULL(err);
+
+  const char *expected = "NOTIFY sip:watcher@example.com SIP/2.0\r\n"
+                         "Event: presence;id=1\r\n"
+                         "Subscription-State: active;expires=600\r\n"
+                         "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, out_buf, out_len);
+}
+
+void test_generate_parsed_identity_headers(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "P-Asserted-Identity: \"Alice\" <sip:alice@example.com>\r\n"
+                    "P-Asserted-Identity: tel:+15551234;x-src=gw1\r\n"
+                    "P-Preferred-Identity: <sip:alice@example.com>;x-src=ua\r\n"
+                    "Diversion: <sip:bob@example.com>;reason=busy\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+
+  uint32_t out_len = 0;
+  cme_error_t err = cmsc_generate_sip(msg, &out_len, &out_buf);
+  TEST_ASSERT_NULL(err);
+
+  // Identities are joined in place of the first one, keeping their form
+  const char *expected =
+      "INVITE sip:bob@example.com SIP/2.0\r\n"
+      "P-Asserted-Identity: \"Alice\" <sip:alice@example.com>, "
+      "tel:+15551234;x-src=gw1\r\n"
+      "P-Preferred-Identity: <sip:alice@example.com>;x-src=ua\r\n"
+      "Diversion: <sip:bob@example.com>;reason=busy\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, out_buf, out_len);
+}
+
+void test_generate_parsed_response_numbers(void) {
+  const char *raw =
+      "SIP/2.0 180 Ringing\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776;ttl=16\r\n"
+      "To: <sip:bob@example.com>\r\n"
+      "From: <sip:alice@example.com>;tag=1928301774\r\n"
+      "CSeq: 4294967295 INVITE\r\n"
+      "Expires: 0\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+
+  uint32_t out_len = 0;
+  cme_error_t err = cmsc_generate_sip(msg, &out_len, &out_buf);
+  TEST_ASSERT_NULL(err);
+
+  // From keeps its tag even if To has none
+  const char *expected =
+      "SIP/2.0 180 Ringing\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776;ttl=16\r\n"
+      "To: sip:bob@example.com\r\n"
+      "From: sip:alice@example.com;tag=1928301774\r\n"
+      "CSeq: 4294967295 INVITE\r\n"
+      "Content-Length: 0\r\n"
+      "Expires: 0\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, out_buf, out_len);
+}
+
+void test_generate_size_matches_generated_message(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "To: <sip:bob@example.com>\r\n"
+                    "CSeq: 7 INVITE\r\n"
+                    "X-Custom: value\r\n"
+                    "Content-Length: 4\r\n"
+                    "\r\n"
+                    "body";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+
+  uint32_t size = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip_size(msg, &size));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+  TEST_ASSERT_EQUAL(out_len, size);
+  TEST_ASSERT_EQUAL(strlen(out_buf), out_len);
+}
+
+void test_generate_message_longer_than_estimate(void) {
+  TEST_ASSERT_NULL(cmsc_sipmsg_create_with_buf(&msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_request_line(
+      7, "SIP/2.0", 21, "sip:alice@example.com", 7, "OPTIONS", msg));
+
+  // Each header keeps 2 bytes in message buffer but generates 6
+  for (uint32_t i = 0; i < 100; i++) {
+    TEST_ASSERT_NULL(cmsc_sipmsg_insert_header(1, "X", 1, "1", msg));
+  }
+
+  uint32_t size = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip_size(msg, &size));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+  TEST_ASSERT_EQUAL(size, out_len);
+  TEST_ASSERT_EQUAL(strlen("OPTIONS sip:alice@example.com SIP/2.0\r\n") +
+                        100 * strlen("X: 1\r\n") + strlen("\r\n"),
+                    out_len);
+  TEST_ASSERT_EQUAL(out_len, strlen(out_buf));
+}
+
+void test_generate_size_without_first_line(void) {
+  TEST_ASSERT_NULL(cmsc_sipmsg_create_with_buf(&msg));
+
+  uint32_t size = 0;
+  cme_error_t err = cmsc_generate_sip_size(msg, &size);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+}
+
+void test_generate_into_caller_buffer(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "CSeq: 1 OPTIONS\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+
+  char dst[128];
+  uint32_t len = 0;
+  cme_error_t err = cmsc_generate_sip_into(msg, dst, 10, &len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+  TEST_ASSERT_EQUAL(strlen(raw), len);
+
+  len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip_into(msg, dst, strlen(raw), &len));
+  TEST_ASSERT_EQUAL(strlen(raw), len);
+  TEST_ASSERT_EQUAL_STRING_LEN(raw, dst, len);
+}
+
+void test_generate_iov_references_message_buffer(void) {
+  const char *raw = "MESSAGE sip:bob@biloxi.example.com SIP/2.0\r\n"
+                    "Call-ID: a84b4c76e66710@pc33.atlanta.example.com\r\n"
+                    "CSeq: 1 MESSAGE\r\n"
+                    "Content-Length: 28\r\n"
+                    "\r\n"
+                    "Watson, come here. I want...";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  char scratch[256];
+  struct iovec iov[16];
+  uint32_t iov_len = 0;
+  TEST_ASSERT_NULL(
+      cmsc_generate_sip_iov(msg, scratch, sizeof(scratch), iov, 16, &iov_len));
+
+  char joined[256];
+  uint32_t joined_len = 0;
+  for (uint32_t i = 0; i < iov_len; i++) {
+    memcpy(joined + joined_len, iov[i].iov_base, iov[i].iov_len);
+    joined_len += iov[i].iov_len;
+  }
+  TEST_ASSERT_EQUAL(out_len, joined_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(out_buf, joined, joined_len);
+
+  // Body is referenced, not copied
+  struct iovec *body = &iov[iov_len - 1];
+  TEST_ASSERT_EQUAL_PTR(raw_cp + strlen(raw_cp) - 28, body->iov_base);
+  TEST_ASSERT_EQUAL(28, body->iov_len);
+
+  cme_error_t err =
+      cmsc_generate_sip_iov(msg, scratch, sizeof(scratch), iov, 1, &iov_len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+}
+
+void test_generate_compact_form(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "To: <sip:bob@example.com>\r\n"
+                    "From: <sip:alice@example.com>;tag=1928301774\r\n"
+                    "Call-ID: a84b4c76e66710\r\n"
+                    "CSeq: 1 INVITE\r\n"
+                    "Supported: timer, 100rel\r\n"
+                    "Contact: <sip:alice@pc33.example.com>\r\n"
+                    "X-Custom: value\r\n"
+                    "Content-Length: 0\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_compact_form = true;
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  const char *expected = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                         "v:SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                         "t:sip:bob@example.com\r\n"
+                         "f:sip:alice@example.com;tag=1928301774\r\n"
+                         "i:a84b4c76e66710\r\n"
+                         "CSeq:1 INVITE\r\n"
+                         "l:0\r\n"
+                         "k:100rel,timer\r\n"
+                         "m:<sip:alice@pc33.example.com>\r\n"
+                         "X-Custom:value\r\n"
+                         "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(expected, out_buf, out_len);
+
+  uint32_t size = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip_size(msg, &size));
+  TEST_ASSERT_EQUAL(out_len, size);
+}
+
+void test_generate_parsed_message_passes_through(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "Max-Forwards: 70\r\n"
+                    "v:SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "X-Custom:   value\r\n"
+                    "To:  <sip:bob@example.com>\r\n"
+                    "CSeq:  7   INVITE\r\n"
+                    "l: 4\r\n"
+                    "\r\n"
+                    "body";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+  TEST_ASSERT_EQUAL(strlen(raw), out_len);
+  TEST_ASSERT_EQUAL_STRING(raw, out_buf);
+
+  // Header lines are referenced as one run, short body is copied with CRLF
+  char scratch[64];
+  struct iovec iov[4];
+  uint32_t iov_len = 0;
+  TEST_ASSERT_NULL(
+      cmsc_generate_sip_iov(msg, scratch, sizeof(scratch), iov, 4, &iov_len));
+  TEST_ASSERT_EQUAL(2, iov_len);
+  TEST_ASSERT_EQUAL_PTR(raw_cp, iov[0].iov_base);
+  TEST_ASSERT_EQUAL(strlen(raw) - strlen("\r\nbody"), iov[0].iov_len);
+}
+
+void test_generate_parsed_message_encodes_dirty_fields(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "To:  <sip:bob@example.com>\r\n"
+                    "CSeq:  7   INVITE\r\n"
+                    "X-Custom:   value\r\n"
+                    "Call-ID: a84b4c76e66710\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_cseq(strlen("BYE"), "BYE", 8, msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_body(strlen("body"), "body", msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_header(strlen("X-New"), "X-New",
+                                             strlen("1"), "1", msg));
+  msg->presence_mask &= ~cmsc_SupportedSipHeaders_TO;
+
+  // Inserted values are copied, so parsed buffer is left untouched
+  TEST_ASSERT_EQUAL_STRING(raw, raw_cp);
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  const char *expected = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                         "CSeq: 8 BYE\r\n"
+                         "X-Custom:   value\r\n"
+                         "Call-ID: a84b4c76e66710\r\n"
+                         "Content-Length: 4\r\n"
+                         "X-New: 1\r\n"
+                         "\r\n"
+                         "body";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+
+  uint32_t size = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip_size(msg, &size));
+  TEST_ASSERT_EQUAL(out_len, size);
+}
+
+void test_generate_parsed_message_with_edited_fields(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "CSeq: 1 INVITE\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->cseq.seq_number = 2;
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+  TEST_ASSERT_EQUAL_STRING("INVITE sip:bob@example.com SIP/2.0\r\n"
+                           "CSeq: 2 INVITE\r\n"
+                           "\r\n",
+                           out_buf);
+
+  // Passed through lines need direct edits to be marked
+  free((void *)out_buf);
+  msg->is_pass_through = true;
+  msg->cseq.seq_number = 3;
+  cmsc_sipmsg_mark_field_dirty(msg, cmsc_SupportedSipHeaders_CSEQ);
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+  TEST_ASSERT_EQUAL_STRING("INVITE sip:bob@example.com SIP/2.0\r\n"
+                           "CSeq: 3 INVITE\r\n"
+                           "\r\n",
+                           out_buf);
+}
+
+void test_generate_forwarded_request(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "Max-Forwards: 70\r\n"
+                    "Route: <sip:p1.example.com;lr>, "
+                    "<sip:p2.example.com;lr>\r\n"
+                    "CSeq: 1 INVITE\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+
+  const char *proto = "SIP/2.0/UDP";
+  const char *sent_by = "p1.example.com";
+  const char *branch = "z9hG4bK1";
+  TEST_ASSERT_NULL(cmsc_sipmsg_prepend_via(
+      strlen(proto), proto, strlen(sent_by), sent_by, 0, NULL, strlen(branch),
+      branch, 0, NULL, 0, true, msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_decrement_max_forwards(msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_pop_route(msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_prepend_record_route(
+      strlen("sip:p1.example.com;lr"), "sip:p1.example.com;lr", 0, NULL, msg));
+
+  cme_error_t err = cmsc_sipmsg_prepend_record_route(0, "", 0, NULL, msg);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  const char *expected =
+      "INVITE sip:bob@example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP p1.example.com;branch=z9hG4bK1;rport\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "Max-Forwards: 69\r\n"
+      "Route: <sip:p2.example.com;lr>\r\n"
+      "CSeq: 1 INVITE\r\n"
+      "Record-Route: <sip:p1.example.com;lr>\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+
+  // Last route drops the header
+  TEST_ASSERT_NULL(cmsc_sipmsg_pop_route(msg));
+  err = cmsc_sipmsg_pop_route(msg);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOENT, err->code);
+  TEST_ASSERT_FALSE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_ROUTE));
+}
+
+void test_generate_forwarded_response(void) {
+  const char *raw = "SIP/2.0 200 OK\r\n"
+                    "Via: SIP/2.0/UDP p1.example.com;branch=z9hG4bK1, "
+                    "SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "CSeq: 1 INVITE\r\n"
+                    "\r\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+  TEST_ASSERT_NULL(cmsc_sipmsg_pop_via(msg));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  const char *expected =
+      "SIP/2.0 200 OK\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "CSeq: 1 INVITE\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+
+  // Max-Forwards of zero is not decremented
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_max_forwards(0, msg));
+  cme_error_t err = cmsc_sipmsg_decrement_max_forwards(msg);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ELOOP, err->code);
+}
+
+void test_generate_response_to_parsed_request(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "Max-Forwards: 70\r\n"
+                    "To: Bob <sip:bob@example.com>\r\n"
+                    "From: Alice <sip:alice@example.com>;tag=1928301774\r\n"
+                    "Call-ID: a84b4c76e66710\r\n"
+                    "CSeq: 314159 INVITE\r\n"
+                    "Content-Length: 4\r\n"
+                    "\r\n"
+                    "v=0\n";
+  char *raw_cp = strdup(raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+  TEST_ASSERT_NULL(cmsc_make_response(msg, 180, strlen("Ringing"), "Ringing",
+                                      strlen("a6c85cf"), "a6c85cf", &resp));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(resp, &out_len, &out_buf));
+
+  const char *expected =
+      "SIP/2.0 180 Ringing\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "To: Bob <sip:bob@example.com>;tag=a6c85cf\r\n"
+      "From: Alice <sip:alice@example.com>;tag=1928301774\r\n"
+      "Call-ID: a84b4c76e66710\r\n"
+      "CSeq: 314159 INVITE\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+  TEST_ASSERT_EQUAL(314159, resp->cseq.seq_number);
+
+  // Response does not depend on request
+  cmsc_sipmsg_destroy_with_buf(&msg);
+  free((void *)out_buf);
+  out_buf = NULL;
+  TEST_ASSERT_NULL(cmsc_generate_sip(resp, &out_len, &out_buf));
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+}
+
+void test_generate_response_to_built_request(void) {
+  const char *proto = "SIP/2.0/UDP";
+  const char *sent_by = "pc33.example.com";
+  const char *branch = "z9hG4bK776";
+  TEST_ASSERT_NULL(cmsc_sipmsg_create_with_buf(&msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_request_line(
+      strlen("SIP/2.0"), "SIP/2.0", strlen("sip:bob@example.com"),
+      "sip:bob@example.com", strlen("OPTIONS"), "OPTIONS", msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_via(strlen(proto), proto,
+                                          strlen(sent_by), sent_by, 0, NULL,
+                                          strlen(branch), branch, 0, NULL, 0,
+                                          false, msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_to(strlen("sip:bob@example.com"),
+                                         "sip:bob@example.com", strlen("x1"),
+                                         "x1", msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_cseq(strlen("OPTIONS"), "OPTIONS", 2,
+                                           msg));
+
+  // To already has a tag, so given one is ignored
+  TEST_ASSERT_NULL(cmsc_make_response(msg, 486, strlen("Busy Here"),
+                                      "Busy Here", strlen("y2"), "y2", &resp));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(resp, &out_len, &out_buf));
+
+  TEST_ASSERT_EQUAL_STRING(
+      "SIP/2.0 486 Busy Here\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "To: sip:bob@example.com;tag=x1\r\n"
+      "CSeq: 2 OPTIONS\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n",
+      out_buf);
+
+  // Responses are made only to requests
+  struct cmsc_SipMessage *resp_of_resp = NULL;
+  cme_error_t err =
+      cmsc_make_response(resp, 200, 2, "OK", 0, NULL, &resp_of_resp);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+}
+
+static const char *invite_raw =
+    "INVITE sip:bob@example.com SIP/2.0\r\n"
+    "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776, "
+    "SIP/2.0/UDP p1.example.com;branch=z9hG4bK1\r\n"
+    "Max-Forwards: 69\r\n"
+    "Route: <sip:p2.example.com;lr>\r\n"
+    "To: Bob <sip:bob@example.com>\r\n"
+    "From: Alice <sip:alice@example.com>;tag=1928301774\r\n"
+    "Call-ID: a84b4c76e66710\r\n"
+    "CSeq: 314159 INVITE\r\n"
+    "Contact: <sip:alice@pc33.example.com>\r\n"
+    "Content-Length: 4\r\n"
+    "\r\n"
+    "v=0\n";
+
+void test_generate_cancel_of_invite(void) {
+  char *raw_cp = strdup(invite_raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+  TEST_ASSERT_NULL(cmsc_make_cancel(msg, &resp));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(resp, &out_len, &out_buf));
+
+  const char *expected =
+      "CANCEL sip:bob@example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "Max-Forwards: 69\r\n"
+      "Route: <sip:p2.example.com;lr>\r\n"
+      "To: Bob <sip:bob@example.com>\r\n"
+      "From: Alice <sip:alice@example.com>;tag=1928301774\r\n"
+      "Call-ID: a84b4c76e66710\r\n"
+      "CSeq: 314159 CANCEL\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+}
+
+void test_generate_ack_of_non_2xx(void) {
+  const char *resp_raw = "SIP/2.0 486 Busy Here\r\n"
+                         "To: Bob <sip:bob@example.com>;tag=a6c85cf\r\n"
+                         "CSeq: 314159 INVITE\r\n"
+                         "\r\n";
+  char *raw_cp = strdup(invite_raw);
+  TEST_ASSERT_NOT_NULL(raw_cp);
+  struct cmsc_SipMessage *busy = NULL;
+  struct cmsc_SipMessage *ack = NULL;
+
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(raw_cp), raw_cp, &msg));
+  msg->is_pass_through = true;
+  TEST_ASSERT_NULL(cmsc_parse_sip(strlen(resp_raw), resp_raw, &busy));
+
+  // Response to INVITE is not a final non-2xx response
+  TEST_ASSERT_NULL(cmsc_make_response(msg, 200, 2, "OK", 0, NULL, &resp));
+  cme_error_t err = cmsc_make_ack(msg, resp, &ack);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+
+  TEST_ASSERT_NULL(cmsc_make_ack(msg, busy, &ack));
+  cmsc_sipmsg_destroy(&busy);
+
+  uint32_t out_len = 0;
+  err = cmsc_generate_sip(ack, &out_len, &out_buf);
+  cmsc_sipmsg_destroy_with_buf(&ack);
+  TEST_ASSERT_NULL(err);
+
+  const char *expected =
+      "ACK sip:bob@example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "Max-Forwards: 69\r\n"
+      "Route: <sip:p2.example.com;lr>\r\n"
+      "To: Bob <sip:bob@example.com>;tag=a6c85cf\r\n"
+      "From: Alice <sip:alice@example.com>;tag=1928301774\r\n"
+      "Call-ID: a84b4c76e66710\r\n"
+      "CSeq: 314159 ACK\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n";
+
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  TEST_ASSERT_EQUAL_STRING(expected, out_buf);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+#include "utils/bstring.h"
+#include "utils/sipmsg.h"
+
+static struct cmsc_SipMessage *msg = NULL;
+static struct cmsc_MultipartBody multipart;
+
+void setUp(void) { TEST_ASSERT_NULL(cmsc_init()); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
+
+void test_parse_multipart_sdp_and_pidf(void) {
+  make_msg_with_body("INVITE", "multipart/mixed;boundary=\"unique-boundary-1\"",
+                     "preamble to be ignored\r\n"
+                     "--unique-boundary-1\r\n"
+                     "Content-Type: application/sdp\r\n"
+                     "\r\n"
+                     "v=0\r\n"
+                     "s=-\r\n"
+                     "\r\n"
+                     "--unique-boundary-1  \r\n"
+                     "Content-Type: application/pidf+xml\r\n"
+                     "Content-ID: <target123@atlanta.example.com>\r\n"
+                     "\r\n"
+                     "<presence/>\r\n"
+                     "--unique-boundary-1--\r\n"
+                     "epilogue\r\n", &msg);
+
+  cme_error_t err = cmsc_parse_multipart(msg, &multipart);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(2, multipart.parts_len);
+
+  ASSERT_BSTRING("Content-Type: application/sdp", multipart.parts[0].headers);
+  ASSERT_BSTRING("v=0\r\ns=-\r\n", multipart.parts[0].body);
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_APPLICATION_SDP,
+                    multipart.parts[0].content_type.media_type);
+
+  ASSERT_BSTRING("Content-Type: application/pidf+xml\r\n"
+                 "Content-ID: <target123@atlanta.example.com>",
+                 multipart.parts[1].headers);
+  ASSERT_BSTRING("<presence/>", multipart.parts[1].body);
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_APPLICATION_PIDF_XML,
+                    multipart.parts[1].content_type.media_type);
+}
+
+void test_parse_multipart_part_without_headers(void) {
+  make_msg_with_body("INVITE", "multipart/mixed; boundary=b1", "--b1\r\n"
+                     "\r\n"
+                     "text with --b1 inside\r\n"
+                     "--b1--", &msg);
+
+  cme_error_t err = cmsc_parse_multipart(msg, &multipart);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(1, multipart.parts_len);
+  TEST_ASSERT_EQUAL(0, multipart.parts[0].headers.len);
+  ASSERT_BSTRING("text with --b1 inside", multipart.parts[0].body);
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_NONE,
+                    multipart.parts[0].content_type.media_type);
+}
+
+void test_parse_multipart_boundary_prefixed_line(void) {
+  make_msg_with_body("INVITE", "multipart/mixed;boundary=b1", "--b1\r\n"
+                     "\r\n"
+                     "--b1extra\r\n"
+                     "--b1 \t\r\n"
+                     "\r\n"
+                     "second\r\n"
+                     "--b1--", &msg);
+
+  cme_error_t err = cmsc_parse_multipart(msg, &multipart);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(2, multipart.parts_len);
+  ASSERT_BSTRING("--b1extra", multipart.parts[0].body);
+  ASSERT_BSTRING("second", multipart.parts[1].body);
+}
+
+void test_parse_multipart_missing_close_delimiter(void) {
+  make_msg_with_body("INVITE", "multipart/mixed;boundary=b1", "--b1\r\n"
+                     "Content-Type: text/plain\r\n"
+                     "\r\n"
+                     "truncated", &msg);
+
+  cme_error_t err = cmsc_parse_multipart(msg, &multipart);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_parse_multipart_missing_boundary(void) {
+  make_msg_with_body("INVITE", "application/sdp", "v=0\r\n", &msg);
+
+  cme_error_t err = cmsc_parse_multipart(msg, &multipart);
+  TEST_ASSERT_NOT_NULL(err);
+}
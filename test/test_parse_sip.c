@@ -4,6 +4,7 @@
  * See LICENSE file in the project root for full license information.
  */
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,8 +18,11 @@
 
 static struct cmsc_SipMessage *msg = NULL;
 
-void setUp(void) { cme_init(); }
-void tearDown(void) { cmsc_sipmsg_destroy(&msg); }
+void setUp(void) { TEST_ASSERT_NULL(cmsc_init()); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
 
 static void parse_msg(const char *raw) {
   cme_error_t err = cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg);
@@ -249,3 +253,106 @@ void test_parse_message_with_body(void) {
   TEST_ASSERT_NOT_EQUAL(0, body.len);  
   MYTEST_ASSERT_EQUAL_STRING_LEN("Hello from body!", body.buf, body.len);
 }
+
+void test_find_generic_headers(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "Path: <sip:p1.example.com;lr>\r\n"
+                    "User-Agent: softphone/1.0\r\n"
+                    "Call-ID: a84b4c76e66710\r\n"
+                    "path: <sip:p2.example.com;lr>\r\n"
+                    "PATH: <sip:p3.example.com;lr>\r\n"
+                    "\r\n";
+
+  parse_msg(raw);
+
+  struct cmsc_SipHeader *header = cmsc_sipmsg_find_header(msg, "user-agent");
+  TEST_ASSERT_NOT_NULL(header);
+  MYTEST_ASSERT_EQUAL_STRING_LEN("softphone/1.0",
+                                 cmsc_bs_msg_to_string(&header->value, msg).buf,
+                                 header->value.len);
+  TEST_ASSERT_NULL(cmsc_sipmsg_next_header(msg, header));
+
+  const char *paths[] = {"<sip:p1.example.com;lr>", "<sip:p2.example.com;lr>",
+                         "<sip:p3.example.com;lr>"};
+  uint32_t paths_len = 0;
+  CMSC_SIPMSG_FOREACH_HEADER(header, "Path", msg) {
+    TEST_ASSERT_LESS_THAN(3, paths_len);
+    MYTEST_ASSERT_EQUAL_STRING_LEN(
+        paths[paths_len], cmsc_bs_msg_to_string(&header->value, msg).buf,
+        header->value.len);
+    paths_len++;
+  }
+  TEST_ASSERT_EQUAL(3, paths_len);
+
+  // Decoded headers are not generic anymore
+  TEST_ASSERT_NULL(cmsc_sipmsg_find_header(msg, "Call-ID"));
+  TEST_ASSERT_NULL(cmsc_sipmsg_find_header(msg, "Contact"));
+}
+
+void test_generic_headers_have_interned_ids(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "v: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+                    "m: <sip:alice@pc33.example.com>\r\n"
+                    "user-agent: softphone/1.0\r\n"
+                    "X-Custom: value\r\n"
+                    "\r\n";
+
+  parse_msg(raw);
+
+  // Compact forms share ids with full names, so Via is decoded
+  TEST_ASSERT_TRUE(
+      cmsc_sipmsg_is_field_present(msg, cmsc_SupportedSipHeaders_VIAS));
+
+  const uint16_t ids[] = {cmsc_HeaderNames_CONTACT, cmsc_HeaderNames_USER_AGENT,
+                          cmsc_HeaderNames_UNKNOWN};
+  uint32_t ids_len = 0;
+  struct cmsc_SipHeader *header;
+  STAILQ_FOREACH(header, &msg->sip_headers, _next) {
+    TEST_ASSERT_LESS_THAN(3, ids_len);
+    TEST_ASSERT_EQUAL(ids[ids_len], header->id);
+    ids_len++;
+  }
+  TEST_ASSERT_EQUAL(3, ids_len);
+}
+
+void test_find_headers_with_compact_names(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "m: <sip:a@example.com>\r\n"
+                    "User-Agent: softphone/1.0\r\n"
+                    "Contact: <sip:c@example.com>\r\n"
+                    "\r\n";
+
+  parse_msg(raw);
+
+  const char *contacts[] = {"<sip:a@example.com>", "<sip:c@example.com>"};
+  const char *names[] = {"Contact", "m", "CONTACT"};
+  struct cmsc_SipHeader *header;
+  for (uint32_t i = 0; i < sizeof(names) / sizeof(char *); i++) {
+    uint32_t contacts_len = 0;
+    CMSC_SIPMSG_FOREACH_HEADER(header, names[i], msg) {
+      TEST_ASSERT_LESS_THAN(2, contacts_len);
+      MYTEST_ASSERT_EQUAL_STRING_LEN(
+          contacts[contacts_len],
+          cmsc_bs_msg_to_string(&header->value, msg).buf, header->value.len);
+      contacts_len++;
+    }
+    TEST_ASSERT_EQUAL(2, contacts_len);
+  }
+}
+
+void test_parse_without_init(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "Call-ID: a84b4c76e66710\r\n"
+                    "\r\n";
+
+  cmsc_destroy();
+  TEST_ASSERT_EQUAL(0, cme_init());
+
+  cme_error_t err = cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+  TEST_ASSERT_NULL(msg);
+
+  cme_destroy();
+  TEST_ASSERT_NULL(cmsc_init());
+}
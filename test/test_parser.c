@@ -18,9 +18,12 @@
 
 static struct cmsc_SipMessage *msg = NULL;
 
-void setUp(void) { cme_init(); }
+void setUp(void) { TEST_ASSERT_NULL(cmsc_init()); }
 
-void tearDown(void) { cmsc_sipmsg_destroy(&msg); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
 
 void test_parse_null_msg(void) {
   cme_error_t err = cmsc_parse_sip_headers(NULL, NULL);
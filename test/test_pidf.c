@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+#include "utils/bstring.h"
+#include "utils/sipmsg.h"
+
+static struct cmsc_SipMessage *msg = NULL;
+static struct cmsc_PidfPresence pidf;
+
+void setUp(void) { TEST_ASSERT_NULL(cmsc_init()); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
+
+void test_parse_pidf_with_rpid_activities(void) {
+  make_msg_with_body(
+      "PUBLISH", "application/pidf+xml",
+      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      "<presence xmlns=\"urn:ietf:params:xml:ns:pidf\"\n"
+      "    xmlns:dm=\"urn:ietf:params:xml:ns:pidf:data-model\"\n"
+      "    xmlns:rpid=\"urn:ietf:params:xml:ns:pidf:rpid\"\n"
+      "    entity=\"pres:alice@example.com\">\n"
+      "  <!-- <tuple id=\"commented\"> -->\n"
+      "  <tuple id='t1'>\n"
+      "    <status><basic>open</basic></status>\n"
+      "    <contact priority=\"0.8\">sip:alice@pc33.example.com</contact>\n"
+      "    <note xml:lang=\"en\"> Ready &amp; waiting </note>\n"
+      "  </tuple>\n"
+      "  <tuple id=\"t2\"><status><basic>closed</basic></status></tuple>\n"
+      "  <dm:person id=\"p1\">\n"
+      "    <rpid:activities>\n"
+      "      <rpid:on-the-phone/>\n"
+      "      <rpid:meeting></rpid:meeting>\n"
+      "    </rpid:activities>\n"
+      "    <dm:note>In a call</dm:note>\n"
+      "  </dm:person>\n"
+      "</presence>\n", &msg);
+
+  cme_error_t err = cmsc_parse_pidf(msg, &pidf);
+  TEST_ASSERT_NULL(err);
+
+  ASSERT_BSTRING("pres:alice@example.com", pidf.entity);
+
+  TEST_ASSERT_EQUAL(2, pidf.tuples_len);
+  ASSERT_BSTRING("t1", pidf.tuples[0].id);
+  ASSERT_BSTRING("open", pidf.tuples[0].basic);
+  ASSERT_BSTRING("sip:alice@pc33.example.com", pidf.tuples[0].contact);
+  ASSERT_BSTRING("Ready &amp; waiting", pidf.tuples[0].note);
+  ASSERT_BSTRING("t2", pidf.tuples[1].id);
+  ASSERT_BSTRING("closed", pidf.tuples[1].basic);
+  TEST_ASSERT_EQUAL(0, pidf.tuples[1].contact.len);
+
+  TEST_ASSERT_EQUAL(2, pidf.activities_len);
+  ASSERT_BSTRING("on-the-phone", pidf.activities[0]);
+  ASSERT_BSTRING("meeting", pidf.activities[1]);
+  ASSERT_BSTRING("In a call", pidf.note);
+}
+
+void test_parse_pidf_doctype_is_skipped(void) {
+  make_msg_with_body(
+      "PUBLISH", "application/pidf+xml",
+      "<!DOCTYPE presence [<!ENTITY lol \"lol\"><!ENTITY lol2 \"&lol;\">]>\n"
+      "<presence entity=\"pres:bob@example.com\">"
+      "<tuple id=\"a\"><status><basic>&lol2;</basic></status></tuple>"
+      "</presence>", &msg);
+
+  cme_error_t err = cmsc_parse_pidf(msg, &pidf);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(1, pidf.tuples_len);
+  ASSERT_BSTRING("&lol2;", pidf.tuples[0].basic);
+}
+
+void test_parse_pidf_mismatched_end_tag(void) {
+  make_msg_with_body("PUBLISH", "application/pidf+xml",
+                     "<presence><tuple id=\"a\"></status></presence>", &msg);
+
+  cme_error_t err = cmsc_parse_pidf(msg, &pidf);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_parse_pidf_unterminated_comment(void) {
+  make_msg_with_body("PUBLISH", "application/pidf+xml",
+                     "<presence><!-- never ends </presence>", &msg);
+
+  cme_error_t err = cmsc_parse_pidf(msg, &pidf);
+  TEST_ASSERT_NOT_NULL(err);
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+#include "utils/bstring.h"
+#include "utils/buffer.h"
+#include "utils/registry.h"
+#include "utils/sipmsg.h"
+
+#define TENANT_SLOT 3
+
+static struct cmsc_SipMessage *msg = NULL;
+static const char *out_buf = NULL;
+
+static cme_error_t decode_tenant(const struct cmsc_SipHeader *sip_header,
+                                 struct cmsc_SipMessage *msg,
+                                 struct cmsc_SipHeaderExtension *extension) {
+  uint32_t *tenant = extension->data;
+  if (!tenant) {
+    tenant = malloc(sizeof(uint32_t));
+    if (!tenant) {
+      return cme_error(ENOMEM, "Cannot allocate memory for `tenant`");
+    }
+    extension->data = tenant;
+  }
+
+  if (!cmsc_s_to_uint32(cmsc_bs_msg_to_string(&sip_header->value, msg),
+                        tenant)) {
+    return cme_error(EINVAL, "Tenant has to be a number");
+  }
+
+  return 0;
+}
+
+static cme_error_t
+encode_tenant(const struct cmsc_SipMessage *msg,
+              const struct cmsc_SipHeaderExtension *extension,
+              struct cmsc_String *value) {
+  static char tenant[16];
+  (void)msg;
+
+  value->len = snprintf(tenant, sizeof(tenant), "%u",
+                        *(uint32_t *)extension->data);
+  value->buf = tenant;
+
+  return 0;
+}
+
+static void destroy_tenant(struct cmsc_SipHeaderExtension *extension) {
+  free(extension->data);
+}
+
+// Every second call emits longer value, so written size exceeds measured one.
+static cme_error_t
+encode_growing(const struct cmsc_SipMessage *msg,
+               const struct cmsc_SipHeaderExtension *extension,
+               struct cmsc_String *value) {
+  static const char growing[] = "0123456789abcdef0123456789abcdef";
+  static uint32_t calls = 1;
+  (void)msg;
+  (void)extension;
+
+  calls = (calls + 1) % 2;
+  *value = (struct cmsc_String){.buf = growing, .len = 16 + 16 * calls};
+
+  return 0;
+}
+
+void setUp(void) {
+  TEST_ASSERT_NULL(cmsc_init());
+
+  struct cmsc_HeaderCodec tenant = {.name = "X-Tenant",
+                                    .slot = TENANT_SLOT,
+                                    .decode_func = decode_tenant,
+                                    .encode_func = encode_tenant,
+                                    .destroy_func = destroy_tenant};
+  TEST_ASSERT_NULL(cmsc_register_header(&tenant));
+  TEST_ASSERT_NULL(cmsc_register_header(
+      &(struct cmsc_HeaderCodec){.name = "X-Raw", .slot = 0}));
+
+  msg = NULL;
+  out_buf = NULL;
+}
+
+void tearDown(void) {
+  free((void *)out_buf);
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
+
+void test_registered_header_is_decoded_into_slot(void) {
+  const char *raw = "INVITE sip:bob@example.com SIP/2.0\r\n"
+                    "Call-ID: a84b4c76e66710\r\n"
+                    "x-tenant: 42\r\n"
+                    "X-Raw:  keep me \r\n"
+                    "X-Other: value\r\n"
+                    "\r\n";
+
+  TEST_ASSERT_NULL(cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg));
+
+  struct cmsc_SipHeaderExtension *tenant =
+      cmsc_sipmsg_get_extension(msg, TENANT_SLOT);
+  TEST_ASSERT_NOT_NULL(tenant);
+  TEST_ASSERT_EQUAL(42, *(uint32_t *)tenant->data);
+
+  struct cmsc_SipHeaderExtension *raw_ext = cmsc_sipmsg_get_extension(msg, 0);
+  TEST_ASSERT_NOT_NULL(raw_ext);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "keep me", cmsc_bs_msg_to_string(&raw_ext->value, msg).buf,
+      raw_ext->value.len);
+
+  TEST_ASSERT_NULL(cmsc_sipmsg_get_extension(msg, 1));
+
+  // Only unregistered headers are left generic
+  struct cmsc_SipHeader *header = STAILQ_FIRST(&msg->sip_headers);
+  TEST_ASSERT_NOT_NULL(header);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "X-Other", cmsc_bs_msg_to_string(&header->key, msg).buf,
+      header->key.len);
+  TEST_ASSERT_NULL(STAILQ_NEXT(header, _next));
+}
+
+void test_registered_header_is_generated(void) {
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "X-Raw: as is\r\n"
+                    "\r\n";
+
+  TEST_ASSERT_NULL(cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg));
+
+  uint32_t *tenant = malloc(sizeof(uint32_t));
+  TEST_ASSERT_NOT_NULL(tenant);
+  *tenant = 7;
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_extension(TENANT_SLOT, tenant, msg));
+
+  uint32_t out_len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip(msg, &out_len, &out_buf));
+
+  TEST_ASSERT_EQUAL_STRING("OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                           "X-Raw: as is\r\n"
+                           "X-Tenant: 7\r\n"
+                           "\r\n",
+                           out_buf);
+}
+
+void test_generate_into_with_growing_extension(void) {
+  TEST_ASSERT_NULL(cmsc_register_header(&(struct cmsc_HeaderCodec){
+      .name = "X-Grow", .slot = 1, .encode_func = encode_growing}));
+
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n\r\n";
+  TEST_ASSERT_NULL(cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_extension(1, NULL, msg));
+
+  // First generation emits 16 bytes of value and second one 32
+  char dst[128];
+  uint32_t len = 0;
+  TEST_ASSERT_NULL(cmsc_generate_sip_into(msg, dst, sizeof(dst), &len));
+
+  // Caller stack memory has to be left alone instead of reallocated
+  cme_error_t err = cmsc_generate_sip_into(msg, dst, len - 16, &len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+}
+
+void test_register_header_conflicts(void) {
+  // Names are case-insensitive, so built-in Via cannot be overridden
+  cme_error_t err = cmsc_register_header(
+      &(struct cmsc_HeaderCodec){.name = "via", .slot = 1});
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_NULL(cmsc_registry_get_codec(1));
+
+  err = cmsc_register_header(
+      &(struct cmsc_HeaderCodec){.name = "X-Other", .slot = TENANT_SLOT});
+  TEST_ASSERT_NOT_NULL(err);
+
+  err = cmsc_register_header(&(struct cmsc_HeaderCodec){
+      .name = "X-Other", .slot = CMSC_MAX_EXTENSION_SLOTS});
+  TEST_ASSERT_NOT_NULL(err);
+
+  make_msg("OPTIONS sip:bob@example.com SIP/2.0\r\n\r\n", &msg);
+  err = cmsc_sipmsg_insert_extension(1, NULL, msg);
+  TEST_ASSERT_NOT_NULL(err);
+
+  // Registry is never built lazily, only cmsc_init builds it
+  cmsc_registry_destroy();
+  err = cmsc_register_header(
+      &(struct cmsc_HeaderCodec){.name = "X-Other", .slot = 1});
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+  TEST_ASSERT_EQUAL(cmsc_HeaderNames_UNKNOWN,
+                    cmsc_registry_find_id(CMSC_BUFFER_LITERAL("Via")));
+}
+
+void test_register_well_known_header(void) {
+  TEST_ASSERT_NULL(cmsc_register_header(
+      &(struct cmsc_HeaderCodec){.name = "User-Agent", .slot = 1}));
+
+  const char *raw = "OPTIONS sip:bob@example.com SIP/2.0\r\n"
+                    "User-Agent: softphone/1.0\r\n"
+                    "\r\n";
+  TEST_ASSERT_NULL(cmsc_parse_sip((uint32_t)strlen(raw), raw, &msg));
+
+  struct cmsc_SipHeaderExtension *user_agent =
+      cmsc_sipmsg_get_extension(msg, 1);
+  TEST_ASSERT_NOT_NULL(user_agent);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "softphone/1.0", cmsc_bs_msg_to_string(&user_agent->value, msg).buf,
+      user_agent->value.len);
+  TEST_ASSERT_TRUE(STAILQ_EMPTY(&msg->sip_headers));
+}
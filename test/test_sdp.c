@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+#include "utils/bstring.h"
+#include "utils/sipmsg.h"
+
+static struct cmsc_SipMessage *msg = NULL;
+static struct cmsc_SdpSession sdp;
+
+void setUp(void) { TEST_ASSERT_NULL(cmsc_init()); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy(&msg);
+  cmsc_destroy();
+}
+
+void test_parse_sdp_audio_offer(void) {
+  make_msg_with_body("INVITE", "application/sdp", "v=0\r\n"
+                     "o=alice 2890844526 2890844526 IN IP4 host.atlanta.com\r\n"
+                     "s=-\r\n"
+                     "c=IN IP4 192.0.2.101\r\n"
+                     "t=0 0\r\n"
+                     "a=sendrecv\r\n"
+                     "m=audio 49170 RTP/AVP 0 8 97 101\r\n"
+                     "a=rtpmap:0 PCMU/8000\r\n"
+                     "a=rtpmap:97 opus/48000/2\r\n"
+                     "a=fmtp:101 0-15\r\n"
+                     "a=rtcp:49171 IN IP4 192.0.2.102\r\n"
+                     "a=ptime:20\r\n", &msg);
+
+  cme_error_t err = cmsc_parse_sdp(msg, &sdp);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(0, sdp.version);
+  ASSERT_BSTRING("alice", sdp.origin.username);
+  ASSERT_BSTRING("2890844526", sdp.origin.session_version);
+  ASSERT_BSTRING("host.atlanta.com", sdp.origin.address);
+  ASSERT_BSTRING("-", sdp.session_name);
+  ASSERT_BSTRING("192.0.2.101", sdp.connection.address);
+  ASSERT_BSTRING("0", sdp.timing.stop);
+  TEST_ASSERT_EQUAL(cmsc_SdpDirections_SENDRECV, sdp.direction);
+
+  TEST_ASSERT_EQUAL(1, sdp.medias_len);
+  struct cmsc_SdpMedia *media = &sdp.medias[0];
+  ASSERT_BSTRING("audio", media->media);
+  TEST_ASSERT_EQUAL(49170, media->port);
+  ASSERT_BSTRING("RTP/AVP", media->proto);
+  ASSERT_BSTRING("0 8 97 101", media->formats);
+  ASSERT_BSTRING("192.0.2.101", media->connection.address);
+  TEST_ASSERT_EQUAL(cmsc_SdpDirections_SENDRECV, media->direction);
+
+  TEST_ASSERT_EQUAL(2, media->rtpmaps_len);
+  TEST_ASSERT_EQUAL(0, media->rtpmaps[0].payload_type);
+  ASSERT_BSTRING("PCMU", media->rtpmaps[0].encoding);
+  TEST_ASSERT_EQUAL(8000, media->rtpmaps[0].clock_rate);
+  TEST_ASSERT_EQUAL(97, media->rtpmaps[1].payload_type);
+  ASSERT_BSTRING("opus", media->rtpmaps[1].encoding);
+  TEST_ASSERT_EQUAL(48000, media->rtpmaps[1].clock_rate);
+  ASSERT_BSTRING("2", media->rtpmaps[1].encoding_params);
+
+  TEST_ASSERT_EQUAL(1, media->fmtps_len);
+  TEST_ASSERT_EQUAL(101, media->fmtps[0].payload_type);
+  ASSERT_BSTRING("0-15", media->fmtps[0].params);
+
+  TEST_ASSERT_EQUAL(49171, media->rtcp_port);
+  ASSERT_BSTRING("192.0.2.102", media->rtcp_connection.address);
+
+  TEST_ASSERT_EQUAL(1, media->attributes_len);
+  ASSERT_BSTRING("ptime", media->attributes[0].name);
+  ASSERT_BSTRING("20", media->attributes[0].value);
+}
+
+void test_parse_sdp_multiple_medias_with_candidates(void) {
+  make_msg_with_body("INVITE", "application/sdp", "v=0\n"
+                     "o=- 1 1 IN IP6 2001:db8::1\n"
+                     "s=call\n"
+                     "t=0 0\n"
+                     "m=audio 5000 RTP/AVP 0\n"
+                     "c=IN IP6 2001:db8::2\n"
+                     "a=recvonly\n"
+                     "a=candidate:1 1 UDP 2130706431 2001:db8::2 5000 typ "
+                     "host\n"
+                     "m=video 0/2 RTP/AVP 96\n"
+                     "a=inactive\n", &msg);
+
+  cme_error_t err = cmsc_parse_sdp(msg, &sdp);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(2, sdp.medias_len);
+  ASSERT_BSTRING("IP6", sdp.medias[0].connection.addr_type);
+  ASSERT_BSTRING("2001:db8::2", sdp.medias[0].connection.address);
+  TEST_ASSERT_EQUAL(cmsc_SdpDirections_RECVONLY, sdp.medias[0].direction);
+
+  TEST_ASSERT_EQUAL(1, sdp.medias[0].candidates_len);
+  struct cmsc_SdpCandidate *candidate = &sdp.medias[0].candidates[0];
+  ASSERT_BSTRING("1", candidate->foundation);
+  TEST_ASSERT_EQUAL(1, candidate->component);
+  ASSERT_BSTRING("UDP", candidate->transport);
+  TEST_ASSERT_EQUAL(2130706431, candidate->priority);
+  ASSERT_BSTRING("2001:db8::2", candidate->address);
+  TEST_ASSERT_EQUAL(5000, candidate->port);
+  ASSERT_BSTRING("host", candidate->type);
+
+  ASSERT_BSTRING("video", sdp.medias[1].media);
+  TEST_ASSERT_EQUAL(0, sdp.medias[1].port);
+  TEST_ASSERT_EQUAL(2, sdp.medias[1].ports_count);
+  TEST_ASSERT_EQUAL(0, sdp.medias[1].connection.address.len);
+  TEST_ASSERT_EQUAL(cmsc_SdpDirections_INACTIVE, sdp.medias[1].direction);
+}
+
+void test_parse_sdp_malformed_line(void) {
+  make_msg_with_body("INVITE", "application/sdp", "v=0\r\n"
+                     "garbage\r\n", &msg);
+
+  cme_error_t err = cmsc_parse_sdp(msg, &sdp);
+  TEST_ASSERT_NOT_NULL(err);
+}
+
+void test_parse_sdp_malformed_attributes(void) {
+  const char *attributes[] = {
+      "a=rtpmap:\r\n",
+      "a=rtpmap:0\r\n",
+      "a=rtpmap:x PCMU/8000\r\n",
+      "a=rtpmap:0 PCMU\r\n",
+      "a=fmtp:\r\n",
+      "a=fmtp:101\r\n",
+      "a=candidate:1 1 UDP 2130706431 192.0.2.1\r\n",
+      "a=candidate:1 1 UDP 2130706431 192.0.2.1 5000 host\r\n",
+      "a=rtcp:\r\n",
+  };
+  char body[256];
+
+  for (uint32_t i = 0; i < sizeof(attributes) / sizeof(char *); i++) {
+    snprintf(body, sizeof(body), "v=0\r\nm=audio 49170 RTP/AVP 0\r\n%s",
+             attributes[i]);
+    make_msg_with_body("INVITE", "application/sdp", body, &msg);
+
+    cme_error_t err = cmsc_parse_sdp(msg, &sdp);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL(EINVAL, err->code);
+
+    cmsc_sipmsg_destroy(&msg);
+  }
+}
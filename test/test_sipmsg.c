@@ -10,18 +10,22 @@
 #include "utils.h"
 #include "utils/bstring.h"
 #include "utils/sipmsg.h"
+#include <stdio.h>
 #include <string.h>
 #include <unity.h>
 
 static struct cmsc_SipMessage *msg = NULL;
 
 void setUp(void) {
-  cme_init();
+  TEST_ASSERT_NULL(cmsc_init());
   cme_error_t err = cmsc_sipmsg_create_with_buf(&msg);
   TEST_ASSERT_NULL(err);
 }
 
-void tearDown(void) { cmsc_sipmsg_destroy_with_buf(&msg); }
+void tearDown(void) {
+  cmsc_sipmsg_destroy_with_buf(&msg);
+  cmsc_destroy();
+}
 
 void test_create_with_buf_null(void) {
   cme_error_t err = cmsc_sipmsg_create_with_buf(NULL);
@@ -115,3 +119,51 @@ void test_insert_body_null_ptr(void) {
   cme_error_t err = cmsc_sipmsg_insert_body(5, "Hello", NULL);
   TEST_ASSERT_NOT_NULL(err);
 }
+
+void test_insert_content_type(void) {
+  const char *type = "multipart/mixed";
+  const char *params = "boundary=abc";
+
+  cme_error_t err = cmsc_sipmsg_insert_content_type(
+      strlen(type), type, strlen(params), params, msg);
+  TEST_ASSERT_NULL(err);
+
+  TEST_ASSERT_EQUAL(cmsc_MediaTypes_MULTIPART_MIXED,
+                    msg->content_type.media_type);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(
+      "abc", cmsc_bs_msg_to_string(&msg->content_type.boundary, msg).buf,
+      msg->content_type.boundary.len);
+}
+
+void test_find_header_after_index_is_rebuilt(void) {
+  char key[32];
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_header(4, "X-Id", 1, "a", msg));
+  TEST_ASSERT_NOT_NULL(cmsc_sipmsg_find_header(msg, "x-id"));
+  TEST_ASSERT_NOT_NULL(msg->_headers_index);
+
+  // Names inserted after first lookup outgrow the index
+  for (uint32_t i = 0; i < 32; i++) {
+    snprintf(key, sizeof(key), "X-Header-%u", i);
+    TEST_ASSERT_NULL(cmsc_sipmsg_insert_header(strlen(key), key, 1, "a", msg));
+    TEST_ASSERT_NULL(cmsc_sipmsg_insert_header(strlen(key), key, 1, "b", msg));
+  }
+
+  for (uint32_t i = 0; i < 32; i++) {
+    snprintf(key, sizeof(key), "x-header-%u", i);
+    struct cmsc_SipHeader *header = cmsc_sipmsg_find_header(msg, key);
+    TEST_ASSERT_NOT_NULL(header);
+    MYTEST_ASSERT_EQUAL_STRING_LEN(
+        "a", cmsc_bs_msg_to_string(&header->value, msg).buf,
+        header->value.len);
+
+    header = cmsc_sipmsg_next_header(msg, header);
+    TEST_ASSERT_NOT_NULL(header);
+    MYTEST_ASSERT_EQUAL_STRING_LEN(
+        "b", cmsc_bs_msg_to_string(&header->value, msg).buf,
+        header->value.len);
+    TEST_ASSERT_NULL(cmsc_sipmsg_next_header(msg, header));
+  }
+  TEST_ASSERT_EQUAL(33, msg->_headers_index_len);
+
+  TEST_ASSERT_NULL(cmsc_sipmsg_find_header(msg, "X-Missing"));
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2025 Jakub Buczynski <KubaTaba1uga>
+ * SPDX-License-Identifier: MIT
+ * See LICENSE file in the project root for full license information.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_wrapper.h"
+#include <c_minilib_sip_codec.h>
+
+#include "utils.h"
+
+static struct cmsc_SipMessage *msg = NULL;
+static struct cmsc_Template *tmpl = NULL;
+
+void setUp(void) {
+  TEST_ASSERT_NULL(cmsc_init());
+  msg = NULL;
+  tmpl = NULL;
+}
+
+void tearDown(void) {
+  cmsc_template_destroy(&tmpl);
+  cmsc_sipmsg_destroy_with_buf(&msg);
+  cmsc_destroy();
+}
+
+#define STRING(literal)                                                        \
+  ((struct cmsc_String){.buf = literal, .len = strlen(literal)})
+
+void test_template_render(void) {
+  const char *raw = "SIP/2.0 100 Trying\r\n"
+                    "Via: ${via}\r\n"
+                    "To: <sip:bob@example.com>\r\n"
+                    "From: <sip:alice@example.com>;tag=${from_tag}\r\n"
+                    "Call-ID: ${call_id}\r\n"
+                    "CSeq: ${cseq} INVITE\r\n"
+                    "X-Call-ID: ${call_id}\r\n"
+                    "Content-Length: 0\r\n"
+                    "\r\n";
+
+  TEST_ASSERT_NULL(cmsc_template_create(strlen(raw), raw, &tmpl));
+  TEST_ASSERT_EQUAL(4, tmpl->names_len);
+
+  uint32_t call_id;
+  TEST_ASSERT_NULL(cmsc_template_find(tmpl, "call_id", &call_id));
+  TEST_ASSERT_EQUAL(2, call_id);
+
+  struct cmsc_String values[] = {
+      STRING("SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776"),
+      STRING("1928301774"),
+      STRING("a84b4c76e66710"),
+      STRING("314159"),
+  };
+  char out[512];
+  uint32_t out_len;
+  TEST_ASSERT_NULL(
+      cmsc_template_render(tmpl, values, 4, out, sizeof(out), &out_len));
+
+  const char *expected =
+      "SIP/2.0 100 Trying\r\n"
+      "Via: SIP/2.0/UDP pc33.example.com;branch=z9hG4bK776\r\n"
+      "To: <sip:bob@example.com>\r\n"
+      "From: <sip:alice@example.com>;tag=1928301774\r\n"
+      "Call-ID: a84b4c76e66710\r\n"
+      "CSeq: 314159 INVITE\r\n"
+      "X-Call-ID: a84b4c76e66710\r\n"
+      "Content-Length: 0\r\n"
+      "\r\n";
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected, out, out_len);
+
+  // Rendering does not consume template
+  values[3] = STRING("2");
+  TEST_ASSERT_NULL(
+      cmsc_template_render(tmpl, values, 4, out, sizeof(out), &out_len));
+  TEST_ASSERT_EQUAL(strlen(expected) - 5, out_len);
+
+  cme_error_t err = cmsc_template_render(tmpl, values, 4, out, 10, &out_len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+  TEST_ASSERT_EQUAL(strlen(expected) - 5, out_len);
+
+  err = cmsc_template_render(tmpl, values, 3, out, sizeof(out), &out_len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(EINVAL, err->code);
+
+  err = cmsc_template_find(tmpl, "nonce", &call_id);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOENT, err->code);
+}
+
+void test_template_create_from_sip(void) {
+  TEST_ASSERT_NULL(cmsc_sipmsg_create_with_buf(&msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_status_line(
+      strlen("SIP/2.0"), "SIP/2.0", strlen("Unauthorized"), "Unauthorized",
+      401, msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_call_id(strlen("${call_id}"),
+                                              "${call_id}", msg));
+  TEST_ASSERT_NULL(cmsc_sipmsg_insert_header(
+      strlen("WWW-Authenticate"), "WWW-Authenticate",
+      strlen("Digest realm=\"example.com\", nonce=\"${nonce}\""),
+      "Digest realm=\"example.com\", nonce=\"${nonce}\"", msg));
+
+  TEST_ASSERT_NULL(cmsc_template_create_from_sip(msg, &tmpl));
+  TEST_ASSERT_EQUAL(2, tmpl->names_len);
+
+  struct cmsc_String values[] = {STRING("a84b4c76e66710"), STRING("dcd98b7")};
+  char out[512];
+  uint32_t out_len;
+  TEST_ASSERT_NULL(
+      cmsc_template_render(tmpl, values, 2, out, sizeof(out), &out_len));
+
+  const char *expected =
+      "SIP/2.0 401 Unauthorized\r\n"
+      "Call-ID: a84b4c76e66710\r\n"
+      "WWW-Authenticate: Digest realm=\"example.com\", nonce=\"dcd98b7\"\r\n"
+      "\r\n";
+  TEST_ASSERT_EQUAL(strlen(expected), out_len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected, out, out_len);
+}
+
+void test_template_invalid_placeholder(void) {
+  const char *invalid[] = {"Call-ID: ${call_id\r\n", "Call-ID: ${}\r\n",
+                           "Call-ID: ${call id}\r\n", "Call-ID: ${"};
+
+  for (uint32_t i = 0; i < sizeof(invalid) / sizeof(char *); i++) {
+    cme_error_t err =
+        cmsc_template_create(strlen(invalid[i]), invalid[i], &tmpl);
+    TEST_ASSERT_NOT_NULL(err);
+    TEST_ASSERT_EQUAL(EINVAL, err->code);
+    TEST_ASSERT_NULL(tmpl);
+  }
+
+  // Dollar sign without brace is not a placeholder
+  const char *raw = "X-Price: $5\r\n";
+  TEST_ASSERT_NULL(cmsc_template_create(strlen(raw), raw, &tmpl));
+  TEST_ASSERT_EQUAL(0, tmpl->names_len);
+}
+
+void test_template_fan_out(void) {
+  const char *raw = "INVITE ${uri} SIP/2.0\r\n"
+                    "Via: SIP/2.0/UDP p1.example.com;branch=${branch}\r\n"
+                    "CSeq: 1 INVITE\r\n"
+                    "\r\n";
+  TEST_ASSERT_NULL(cmsc_template_create(strlen(raw), raw, &tmpl));
+
+  struct cmsc_String values[] = {
+      STRING("sip:bob@pc1.example.com"),    STRING("z9hG4bK1"),
+      STRING("sip:bob@pc2.example.com"),    STRING("z9hG4bK2"),
+      STRING("sip:bob@mobile.example.com"), STRING("z9hG4bK3"),
+  };
+  const char *expected[] = {
+      "INVITE sip:bob@pc1.example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP p1.example.com;branch=z9hG4bK1\r\n"
+      "CSeq: 1 INVITE\r\n"
+      "\r\n",
+      "INVITE sip:bob@pc2.example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP p1.example.com;branch=z9hG4bK2\r\n"
+      "CSeq: 1 INVITE\r\n"
+      "\r\n",
+      "INVITE sip:bob@mobile.example.com SIP/2.0\r\n"
+      "Via: SIP/2.0/UDP p1.example.com;branch=z9hG4bK3\r\n"
+      "CSeq: 1 INVITE\r\n"
+      "\r\n",
+  };
+  char out[512];
+  uint32_t lens[3];
+
+  cme_error_t err =
+      cmsc_template_render_many(tmpl, values, 2, 3, out, 100, lens);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+  TEST_ASSERT_EQUAL(strlen(expected[2]), lens[2]);
+
+  TEST_ASSERT_NULL(
+      cmsc_template_render_many(tmpl, values, 2, 3, out, sizeof(out), lens));
+
+  const char *instance = out;
+  for (uint32_t i = 0; i < 3; i++) {
+    TEST_ASSERT_EQUAL(strlen(expected[i]), lens[i]);
+    MYTEST_ASSERT_EQUAL_STRING_LEN(expected[i], instance, lens[i]);
+    instance += lens[i];
+  }
+
+  // Iovecs of each instance share template text
+  struct iovec iov[CMSC_TEMPLATE_IOV_MAX];
+  uint32_t iov_len;
+  TEST_ASSERT_NULL(cmsc_template_render_iov(tmpl, &values[4], 2, iov,
+                                            CMSC_TEMPLATE_IOV_MAX, &iov_len));
+  TEST_ASSERT_EQUAL(5, iov_len);
+  TEST_ASSERT_EQUAL_PTR(values[4].buf, iov[1].iov_base);
+
+  char joined[512];
+  uint32_t joined_len = 0;
+  for (uint32_t i = 0; i < iov_len; i++) {
+    memcpy(joined + joined_len, iov[i].iov_base, iov[i].iov_len);
+    joined_len += iov[i].iov_len;
+  }
+  TEST_ASSERT_EQUAL(strlen(expected[2]), joined_len);
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected[2], joined, joined_len);
+
+  err = cmsc_template_render_iov(tmpl, &values[4], 2, iov, 4, &iov_len);
+  TEST_ASSERT_NOT_NULL(err);
+  TEST_ASSERT_EQUAL(ENOBUFS, err->code);
+}
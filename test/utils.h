@@ -5,14 +5,24 @@
  */
 
 #include <c_minilib_error.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/queue.h>
 #include <unity.h>
 
 #include "c_minilib_sip_codec.h"
+#include "unity_wrapper.h"
+#include "utils/bstring.h"
+#include "utils/registry.h"
 #include "utils/sipmsg.h"
 
+// Expects `msg` holding `bstring` to be in scope.
+#define ASSERT_BSTRING(expected, bstring)                                      \
+  MYTEST_ASSERT_EQUAL_STRING_LEN(expected,                                     \
+                                 cmsc_bs_msg_to_string(&(bstring), msg).buf,   \
+                                 (bstring).len)
+
 inline static void make_msg(const char *raw, struct cmsc_SipMessage **msg) {
   struct cmsc_Buffer buf = {
       .buf = raw, .len = (uint32_t)strlen(raw), .size = (uint32_t)strlen(raw)};
@@ -21,6 +31,35 @@ inline static void make_msg(const char *raw, struct cmsc_SipMessage **msg) {
   TEST_ASSERT_NULL(err);
 }
 
+/* Parses request of `method` carrying `body` of `content_type`. Raw message is
+   kept in static buffer, so only one such message can be alive at a time. */
+inline static void make_msg_with_body(const char *method,
+                                      const char *content_type,
+                                      const char *body,
+                                      struct cmsc_SipMessage **msg) {
+  static char raw[4096];
+  int raw_len = snprintf(raw, sizeof(raw),
+                         "%s sip:bob@example.com SIP/2.0\r\n"
+                         "Via: SIP/2.0/UDP pc33.example.com;"
+                         "branch=z9hG4bK776asdhds\r\n"
+                         "To: <sip:bob@example.com>\r\n"
+                         "From: <sip:alice@example.com>;tag=1928301774\r\n"
+                         "Call-ID: a84b4c76e66710\r\n"
+                         "CSeq: 314159 %s\r\n"
+                         "Content-Type: %s\r\n"
+                         "Content-Length: %zu\r\n"
+                         "\r\n"
+                         "%s",
+                         method, method, content_type, strlen(body), body);
+  TEST_ASSERT_TRUE(raw_len > 0 && (size_t)raw_len < sizeof(raw));
+
+  cme_error_t err = cmsc_parse_sip((uint32_t)raw_len, raw, msg);
+  if (err) {
+    puts(err->msg);
+  }
+  TEST_ASSERT_NULL(err);
+}
+
 inline static void create_msg(const char *raw, struct cmsc_SipMessage **msg) {
 
   char *raw_buf = malloc(strlen(raw) + 1);
@@ -45,6 +84,8 @@ inline static struct cmsc_SipHeader *create_hdr(struct cmsc_SipMessage *msg) {
   // Key is from start up to the colon
   hdr->key.buf_offset = 0;
   hdr->key.len = (uint32_t)(colon - buf_start);
+  hdr->id = cmsc_registry_find_id((struct cmsc_String){
+      .buf = buf_start, .len = hdr->key.len});
 
   // Skip colon and optional space
   const char *value_start = colon + 1;